@@ -0,0 +1,12 @@
+/*
+ * Statements that parse both as a declaration and as an expression;
+ * with -fdisambiguate the expressions are discarded
+ */
+struct T { T(int); };
+
+void
+f()
+{
+        T(a);
+        T(b);
+}
@@ -0,0 +1,27 @@
+/*
+ * Function definitions, with an object having a braced initializer
+ * between them, for -fskip-function-bodies
+ */
+struct S
+{
+        int f() const;
+        int g() const { return n; }
+        int n;
+};
+
+int table[] = { 1, 2, 3 };
+
+int
+S::f() const
+{
+        if (n) {
+                return table[n];
+        }
+        return 0;
+}
+
+int
+main()
+{
+        return S{ 1 }.f();
+}
@@ -1,10 +1,19 @@
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <locale>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
 #include <wrutil/codecvt.h>
 #include <wrutil/filesystem.h>
 #include <wrutil/Format.h>
@@ -15,17 +24,37 @@
 #include "lex_parse_options.h"
 
 
-static int process(std::istream &input,
-              int (*action)(std::istream &, const wr::parse::CXXOptions &, int),
-              int status);
+using Action = int (*)(std::istream &, const wr::parse::CXXOptions &, int);
+
+static int process(std::istream &input, const wr::parse::CXXOptions &options,
+                   Action action, int status);
+static int processFile(const wr::u8string_view &file_name,
+                       const wr::parse::CXXOptions &options, Action action,
+                       int status);
+static int processParallel(const wr::parse::CXXOptions &options,
+                           Action action);
+static int precompileTokens(std::istream &input,
+                            const wr::parse::CXXOptions &options, int status);
 
 //--------------------------------------
 
 std::string                           prog_name;
-std::unique_ptr<wr::u8buffer_convert> transcode_buf;
+wr::u8string_view                     input_locale;
 std::vector<wr::u8string_view>        input_files;
 wr::parse::cxx::Language              language = 0;
 wr::parse::cxx::Features              features = 0;
+unsigned                              jobs     = 1;
+
+static thread_local std::ostream *output_stream = nullptr,
+                                 *error_stream  = nullptr;
+
+wr::u8string_view                              prefix_tokens_file;
+wr::u8string_view                              precompile_tokens_file;
+std::unique_ptr<wr::parse::PrecompiledTokens>  prefix_tokens;
+std::unique_ptr<wr::parse::ParseProfile>       parse_profile;
+bool                                           disambiguate = false;
+unsigned                                       parse_threads = 0;
+size_t                                         parse_memo_budget = 0;
 
 //--------------------------------------
 
@@ -38,20 +67,68 @@ static const wr::Option program_options[] = {
                 []() { features |= wr::parse::cxx::IDENTIFIER_DOLLARS; } },
         { "-finline-functions",
                 []() { features |= wr::parse::cxx::INLINE_FUNCTIONS; } },
+        { "-fskip-function-bodies",
+                []() { features |= wr::parse::cxx::SKIP_FUNCTION_BODIES; } },
         { "-fline-comments",
                 []() { features |= wr::parse::cxx::LINE_COMMENTS; } },
         { "-flong-long", []() { features |= wr::parse::cxx::LONG_LONG; } },
         { "-fucns", []() { features |= wr::parse::cxx::UCNS; } },
+        { "-fdisambiguate", []() { disambiguate = true; } },
+        { "-flone-operand-fast-path",
+                []() { features |= wr::parse::cxx::LONE_OPERAND_FAST_PATH; } },
+        { "-fdeferred-actions",
+                []() { features |= wr::parse::cxx::DEFERRED_ACTIONS; } },
+        { "-fliteral-lists",
+                []() { features |= wr::parse::cxx::LITERAL_LISTS; } },
+        { "-ffirst-set-lookahead",
+                []() { features |= wr::parse::cxx::FIRST_SET_LOOKAHEAD; } },
+        { "-fparallel-parse",
+                []() {
+                        parse_threads = std::thread::hardware_concurrency();
+                        if (!parse_threads) {
+                                parse_threads = 1;
+                        }
+                } },
+        { "-fprofile-parser",
+                []() { parse_profile.reset(new wr::parse::ParseProfile); } },
 
         { "-finput-locale", wr::Option::NON_EMPTY_ARG_REQUIRED,
                 [](wr::u8string_view arg) {
-                        transcode_buf.reset(
-                                new wr::u8buffer_convert(
-                                        nullptr,
-                                        new wr::codecvt_utf8_narrow(
-                                                std::locale(arg.char_data())
-                                        )
-                                ));
+                        std::locale(arg.char_data());  // throws if unknown
+                        input_locale = arg;
+                } },
+
+        { "-j", wr::Option::NON_EMPTY_ARG_REQUIRED,
+                [](wr::u8string_view arg) {
+                        char          *end;
+                        unsigned long  n = strtoul(arg.char_data(), &end, 10);
+                        if (*end || !n || (n > 1024)) {
+                                throw wr::Option::InvalidArgument(
+                                                "invalid number of jobs");
+                        }
+                        jobs = static_cast<unsigned>(n);
+                } },
+
+        { "-fparse-memo=", wr::Option::NON_EMPTY_ARG_REQUIRED,
+                [](wr::u8string_view opt, wr::u8string_view arg) {
+                        char          *end;
+                        unsigned long  mib = strtoul(arg.char_data(), &end,
+                                                     10);
+                        if (*end || !mib || (mib > 65536)) {
+                                throw wr::Option::InvalidArgument(
+                                                "invalid memo size");
+                        }
+                        parse_memo_budget = size_t(mib) << 20;
+                } },
+
+        { "-prefix-tokens=", wr::Option::NON_EMPTY_ARG_REQUIRED,
+                [](wr::u8string_view opt, wr::u8string_view arg) {
+                        prefix_tokens_file = arg;
+                } },
+
+        { "-precompile-tokens=", wr::Option::NON_EMPTY_ARG_REQUIRED,
+                [](wr::u8string_view opt, wr::u8string_view arg) {
+                        precompile_tokens_file = arg;
                 } },
 
         { "-std=", wr::Option::NON_EMPTY_ARG_REQUIRED,
@@ -87,7 +164,8 @@ int
 run(
         int          argc,
         const char **argv,
-        int        (*action)(std::istream &, const wr::parse::CXXOptions &, int)
+        Action       action,
+        bool         can_precompile
 )
 try {
         prog_name = wr::to_u8string(wr::path(argv[0]).filename());
@@ -102,42 +180,57 @@ try {
                                 | wr::parse::cxx::CXX_LATEST;
         }
 
-        if (input_files.empty()) {
-                return process(std::cin, action, EXIT_SUCCESS);
+        // shared by all inputs and, with -j, by all workers
+        const wr::parse::CXXOptions options(language, features);
+
+        if (jobs > 1) {
+                if (!precompile_tokens_file.empty()) {
+                        throw std::invalid_argument(
+                                "-j cannot be combined with "
+                                "-precompile-tokens=");
+                } else if (parse_threads) {
+                        throw std::invalid_argument(
+                                "-j cannot be combined with "
+                                "-fparallel-parse");
+                }
         }
 
-        int status = EXIT_SUCCESS;
+        if (!precompile_tokens_file.empty()) {
+                if (!can_precompile) {
+                        throw std::invalid_argument(
+                                "-precompile-tokens= is not supported by "
+                                "this program");
+                } else if (input_files.size() > 1) {
+                        throw std::invalid_argument(
+                                "-precompile-tokens= takes a single prefix "
+                                "header");
+                }
+                action = &precompileTokens;
+        }
 
-        for (const wr::u8string_view &file_name: input_files) {
-                if (file_name == "-") {
-                        status = process(wr::uin, action, status);
-                        continue;
+        if (!prefix_tokens_file.empty()) {
+                try {
+                        prefix_tokens.reset(new wr::parse::PrecompiledTokens(
+                                        prefix_tokens_file.char_data(),
+                                        options));
+                } catch (const std::invalid_argument &err) {
+                        // image is stale; lex without it
+                        wr::print(wr::uerr, "%s: warning: %s\n", prog_name,
+                                  err.what());
+                        prefix_tokens_file = {};
                 }
+        }
 
-                auto              path           = wr::u8path(file_name);
-                std::string       failure_reason;
-                wr::fs_error_code error;
+        if (input_files.empty()) {
+                return process(std::cin, options, action, EXIT_SUCCESS);
+        } else if ((jobs > 1) && (input_files.size() > 1)) {
+                return processParallel(options, action);
+        }
 
-                if (wr::is_directory(path, error)) {
-                        failure_reason = wr::u8strerror(EISDIR);
-                } else if (error) {
-                        failure_reason =
-                                wr::utf8_narrow_cvt().to_utf8(error.message());
-                } else {
-                        std::ifstream input_file(path.native());
-                        if (input_file.is_open()) {
-                                status = process(input_file, action, status);
-                        } else {
-                                failure_reason = u8"reason unknown";
-                        }
-                }
+        int status = EXIT_SUCCESS;
 
-                if (!failure_reason.empty()) {
-                        wr::print(wr::uerr,
-                                  u8"%s: cannot open file \"%s\": %s\n",
-                                  argv[0], file_name, failure_reason);
-                        status = EXIT_FAILURE;
-                }
+        for (const wr::u8string_view &file_name: input_files) {
+                status = processFile(file_name, options, action, status);
         }
 
         return status;
@@ -149,21 +242,261 @@ try {
 
 //--------------------------------------
 
+/*
+ * Lex the prefix header named on the command line and write its token
+ * image to precompile_tokens_file
+ */
+static int
+precompileTokens(
+        std::istream                &input,
+        const wr::parse::CXXOptions &options,
+        int                          status
+)
+{
+        wr::parse::CXXLexer lexer(options, input);
+        std::ofstream       output(precompile_tokens_file.char_data(),
+                                   std::ios::binary);
+
+        wr::parse::PrecompiledTokens::write(output, lexer);
+
+        if (!output) {
+                wr::print(errorStream(), "%s: cannot write \"%s\"\n",
+                          prog_name, precompile_tokens_file);
+                status = EXIT_FAILURE;
+        }
+
+        return input.bad() ? EXIT_FAILURE : status;
+}
+
+//--------------------------------------
+
+/*
+ * Streams to which actions write their output and diagnostics: the
+ * standard streams, or the current file's buffers on a -j worker thread
+ */
+std::ostream &
+outputStream()
+{
+        return output_stream ? *output_stream : wr::uout;
+}
+
+//--------------------------------------
+
+std::ostream &
+errorStream()
+{
+        return error_stream ? *error_stream : wr::uerr;
+}
+
+//--------------------------------------
+
 static int
 process(
-        std::istream  &input,
-        int          (*action)(std::istream &,
-                               const wr::parse::CXXOptions &, int),
-        int            status
+        std::istream                &input,
+        const wr::parse::CXXOptions &options,
+        Action                       action,
+        int                          status
 )
 {
-        std::istream input2(input.rdbuf());
+        std::istream                          input2(input.rdbuf());
+        std::unique_ptr<wr::u8buffer_convert> transcode_buf;
 
-        if (transcode_buf) {
-                transcode_buf->rdbuf(input.rdbuf());
+        if (!input_locale.empty()) {
+                transcode_buf.reset(
+                        new wr::u8buffer_convert(
+                                input.rdbuf(),
+                                new wr::codecvt_utf8_narrow(
+                                        std::locale(input_locale.char_data())
+                                )
+                        ));
                 input2.rdbuf(transcode_buf.get());
         } // else assume straight UTF-8 input
 
-        wr::parse::CXXOptions options(language, features);
         return (*action)(input2, options, status);
 }
+
+//--------------------------------------
+
+static int
+processFile(
+        const wr::u8string_view     &file_name,
+        const wr::parse::CXXOptions &options,
+        Action                       action,
+        int                          status
+)
+{
+        if (file_name == "-") {
+                return process(wr::uin, options, action, status);
+        }
+
+        auto              path           = wr::u8path(file_name);
+        std::string       failure_reason;
+        wr::fs_error_code error;
+
+        if (wr::is_directory(path, error)) {
+                failure_reason = wr::u8strerror(EISDIR);
+        } else if (error) {
+                failure_reason = wr::utf8_narrow_cvt().to_utf8(error.message());
+        } else {
+                std::ifstream input_file(path.native());
+                if (input_file.is_open()) {
+                        status = process(input_file, options, action, status);
+                } else {
+                        failure_reason = u8"reason unknown";
+                }
+        }
+
+        if (!failure_reason.empty()) {
+                wr::print(errorStream(),
+                          u8"%s: cannot open file \"%s\": %s\n",
+                          prog_name, file_name, failure_reason);
+                status = EXIT_FAILURE;
+        }
+
+        return status;
+}
+
+//--------------------------------------
+
+/*
+ * Per-worker deque of input file indices. The owner takes files from the
+ * back; idle workers steal from the front, furthest from where the owner
+ * is working.
+ */
+struct JobQueue
+{
+        std::mutex         lock;
+        std::deque<size_t> files;
+
+        bool
+        take(
+                size_t &file,
+                bool    steal
+        )
+        {
+                std::lock_guard<std::mutex> guard(lock);
+
+                if (files.empty()) {
+                        return false;
+                } else if (steal) {
+                        file = files.front();
+                        files.pop_front();
+                } else {
+                        file = files.back();
+                        files.pop_back();
+                }
+
+                return true;
+        }
+};
+
+//--------------------------------------
+
+/*
+ * Process input_files on a pool of jobs worker threads. The output and
+ * diagnostics for each file are buffered, then written in command-line
+ * order as soon as every file before it has finished, giving the same
+ * output as a sequential run.
+ */
+static int
+processParallel(
+        const wr::parse::CXXOptions &options,
+        Action                       action
+)
+{
+        struct Result
+        {
+                std::string output,
+                            errors;
+                int         status = EXIT_SUCCESS;
+                bool        done   = false;
+        };
+
+        size_t                count    = input_files.size(),
+                              nworkers = std::min<size_t>(jobs, count),
+                              emitted  = 0;
+        std::vector<JobQueue> queues(nworkers);
+        std::vector<Result>   results(count);
+        std::mutex            emit_lock;
+        int                   status   = EXIT_SUCCESS;
+
+        if (parse_profile) {
+                wr::print(wr::uerr,
+                          "%s: warning: -fprofile-parser ignored with -j\n",
+                          prog_name);
+                parse_profile.reset();
+        }
+
+        /* give each worker a contiguous block of files, stacked so that it
+           starts at the front of its block */
+        for (size_t w = 0; w < nworkers; ++w) {
+                size_t begin = count * w / nworkers,
+                       end   = count * (w + 1) / nworkers;
+
+                for (size_t i = end; i > begin; --i) {
+                        queues[w].files.push_back(i - 1);
+                }
+        }
+
+        auto next_file = [&](size_t self, size_t &file) {
+                if (queues[self].take(file, false)) {
+                        return true;
+                }
+                for (size_t i = 1; i < nworkers; ++i) {
+                        if (queues[(self + i) % nworkers].take(file, true)) {
+                                return true;
+                        }
+                }
+                return false;
+        };
+
+        auto work = [&](size_t self) {
+                size_t file;
+
+                while (next_file(self, file)) {
+                        std::ostringstream out, err;
+
+                        output_stream = &out;
+                        error_stream = &err;
+
+                        int file_status = processFile(input_files[file],
+                                                      options, action,
+                                                      EXIT_SUCCESS);
+
+                        std::lock_guard<std::mutex> guard(emit_lock);
+
+                        results[file].output = out.str();
+                        results[file].errors = err.str();
+                        results[file].status = file_status;
+                        results[file].done = true;
+
+                        for (; (emitted < count) && results[emitted].done;
+                               ++emitted) {
+                                Result &r = results[emitted];
+                                wr::uout << r.output;
+                                wr::uerr << r.errors;
+                                if (r.status != EXIT_SUCCESS) {
+                                        status = r.status;
+                                }
+                                r.output = std::string();
+                                r.errors = std::string();
+                        }
+                }
+
+                output_stream = error_stream = nullptr;
+        };
+
+        std::vector<std::thread> threads;
+
+        for (size_t w = 1; w < nworkers; ++w) {
+                threads.emplace_back(work, w);
+        }
+
+        work(0);
+
+        for (std::thread &t: threads) {
+                t.join();
+        }
+
+        return status;
+}
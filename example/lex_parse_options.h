@@ -2,10 +2,25 @@
 #define WRPARSE_LEX_PARSE_OPTIONS_H
 
 #include <iosfwd>
+#include <memory>
+#include <string>
 #include <vector>
 #include <wrutil/Option.h>
+#include <wrparse/cxx/ParseProfile.h>
+#include <wrparse/cxx/PrecompiledTokens.h>
 
 
+extern std::string                                    prog_name;
+extern wr::u8string_view                              prefix_tokens_file;
+extern wr::u8string_view                              precompile_tokens_file;
+extern std::unique_ptr<wr::parse::PrecompiledTokens>  prefix_tokens;
+extern std::unique_ptr<wr::parse::ParseProfile>       parse_profile;
+extern bool                                           disambiguate;
+extern unsigned                                       parse_threads;
+extern size_t                                         parse_memo_budget;
+
+std::ostream &outputStream();
+std::ostream &errorStream();
 
 
 #endif // !WRPARSE_LEX_PARSE_OPTIONS_H
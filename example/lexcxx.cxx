@@ -2,10 +2,13 @@
 #include <wrparse/cxx/CXXTokenKinds.h>
 #include <wrparse/cxx/CXXLexer.h>
 
+#include "lex_parse_options.h"
+
 
 extern int run(int argc, const char **argv,
                int (*action)(std::istream &input,
-                             const wr::parse::CXXOptions &options, int status));
+                             const wr::parse::CXXOptions &options, int status),
+               bool can_precompile);
 
 
 static int
@@ -18,13 +21,17 @@ lex(
         wr::parse::CXXLexer lexer(options, input);
         wr::parse::Token    token;
 
+        if (prefix_tokens) {
+                lexer.setPrefixTokens(*prefix_tokens);
+        }
+
         do {
                 lexer.lex(token);
 
                 switch (token.kind()) {
                 case wr::parse::cxx::TOK_WHITESPACE:
                         if (token.spelling() == "\n") {
-                                wr::uout << '\n';
+                                outputStream() << '\n';
                         }
                         // fall through
                 case wr::parse::TOK_EOF:
@@ -32,16 +39,16 @@ lex(
                         break;
                 default:
                         if (token.flags() & wr::parse::TF_SPACE_BEFORE) {
-                                wr::uout << '_';
+                                outputStream() << '_';
                         }
 
-                        wr::uout << lexer.tokenKindName(token.kind());
+                        outputStream() << lexer.tokenKindName(token.kind());
 
                         if (token.kind() >= wr::parse::cxx::TOK_IDENTIFIER) {
-                                wr::uout << '(' << token.spelling() << ')';
+                                outputStream() << '(' << token.spelling() << ')';
                         }
 
-                        wr::uout << ' ';
+                        outputStream() << ' ';
                 }
         } while (!input.bad() && (token.kind() != wr::parse::TOK_EOF));
 
@@ -49,8 +56,8 @@ lex(
                 status = EXIT_FAILURE;
         }
 
-        wr::uout << std::endl;
+        outputStream() << std::endl;
         return status;
 }
 
-int main(int argc, const char **argv) { return run(argc, argv, &lex); }
+int main(int argc, const char **argv) { return run(argc, argv, &lex, true); }
@@ -1,14 +1,24 @@
+#include <atomic>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 #include <wrutil/uiostream.h>
 #include <wrparse/cxx/CXXLexer.h>
 #include <wrparse/cxx/CXXParser.h>
 #include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/DeclSplitter.h>
+#include <wrparse/cxx/ParseMemo.h>
 #include <wrparse/SPPFOutput.h>
 
+#include "lex_parse_options.h"
+
 
 extern int run(int argc, const char **argv,
                int (*action)(std::istream &input,
-                             const wr::parse::CXXOptions &options, int status));
+                             const wr::parse::CXXOptions &options, int status),
+               bool can_precompile);
 
 //--------------------------------------
 
@@ -16,13 +26,144 @@ struct DiagnosticPrinter : public wr::parse::DiagnosticHandler
 {
         virtual void onDiagnostic(const wr::parse::Diagnostic &d) override
         {
-                wr::print(wr::uerr, "%u:%u: %s: %s\n",
+                wr::print(errorStream(), "%u:%u: %s: %s\n",
+                          d.line(), d.column(), d.describeCategory(), d.text());
+        }
+};
+
+//--------------------------------------
+
+struct DiagnosticBuffer : public wr::parse::DiagnosticHandler
+{
+        std::ostream *out = nullptr;
+
+        virtual void onDiagnostic(const wr::parse::Diagnostic &d) override
+        {
+                wr::print(*out, "%u:%u: %s: %s\n",
                           d.line(), d.column(), d.describeCategory(), d.text());
         }
 };
 
 //--------------------------------------
 
+static void
+printFilterCounts(
+        const wr::parse::CXXParser::Filter &filter
+)
+{
+        wr::print(errorStream(),
+                  "%s (%s): %u examined, %u discarded, %u unresolved\n",
+                  filter.name, filter.nonterminal->name(),
+                  filter.examined, filter.discarded, filter.unresolved);
+}
+
+//--------------------------------------
+
+/*
+ * Parse each top-level declaration on whichever of parse_threads workers
+ * is free, then print the results in source order. Parse trees and
+ * diagnostics for each declaration are buffered so that they are printed
+ * in source order. Output differs from a sequential run nonetheless: the
+ * heads and braces of namespace and linkage blocks are not parsed, so
+ * declarations within them appear as top-level declarations, and each
+ * declaration is parsed by a fresh parser knowing only the names
+ * DeclSplitter found before it. Profiling is not thread-safe and so is not
+ * done here.
+ */
+static int
+parseParallel(
+        wr::parse::CXXLexer         &lexer,
+        const wr::parse::CXXOptions &options,
+        int                          status
+)
+{
+        struct Worker
+        {
+                wr::parse::CXXParser parser;
+                DiagnosticBuffer     diag_out;
+
+                Worker(const wr::parse::CXXOptions &options) :
+                        parser(options) {}
+        };
+
+        wr::parse::DeclSplitter              splitter(lexer);
+        size_t                               count = splitter.split();
+        std::vector<std::string>             output(count),
+                                             errors(count);
+        std::vector<char>                    failed(count, false);
+        std::atomic<size_t>                  next(0);
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        for (unsigned i = 0; i < parse_threads; ++i) {
+                workers.emplace_back(new Worker(options));
+                Worker &w = *workers.back();
+                if (disambiguate) {
+                        w.parser.addStandardFilters();
+                }
+                w.parser.addDiagnosticHandler(w.diag_out);
+        }
+
+        auto work = [&](Worker &w) {
+                for (size_t i; (i = next++) < count; ) {
+                        wr::parse::TokenRun &run = *splitter.runs()[i];
+                        std::ostringstream   out, err;
+
+                        w.diag_out.out = &err;
+                        w.parser.reset();
+                        w.parser.symbols().clear()
+                                          .setParent(&splitter.names());
+                        w.parser.setLexer(run.rewind());
+
+                        auto result = w.parser.parse(
+                                        w.parser.grammar().declaration);
+                        if (result) {
+                                out << *result << std::endl;
+                        }
+
+                        failed[i] = (w.parser.errorCount() != 0);
+                        output[i] = out.str();
+                        errors[i] = err.str();
+                }
+        };
+
+        std::vector<std::thread> threads;
+
+        for (size_t i = 1; i < workers.size(); ++i) {
+                threads.emplace_back(work, std::ref(*workers[i]));
+        }
+
+        work(*workers.front());
+
+        for (std::thread &t: threads) {
+                t.join();
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+                errorStream() << errors[i];
+                outputStream() << output[i];
+                if (failed[i]) {
+                        status = EXIT_FAILURE;
+                }
+        }
+
+        auto &filters = workers.front()->parser.filters();
+
+        for (size_t i = 0; i < filters.size(); ++i) {
+                wr::parse::CXXParser::Filter total = filters[i];
+                for (size_t j = 1; j < workers.size(); ++j) {
+                        const auto &f = workers[j]->parser.filters()[i];
+                        total.examined += f.examined;
+                        total.discarded += f.discarded;
+                        total.unresolved += f.unresolved;
+                }
+                printFilterCounts(total);
+        }
+
+        return status;
+}
+
+//--------------------------------------
+
 static int
 parseCXX(
         std::istream                &input,
@@ -34,33 +175,75 @@ parseCXX(
         wr::parse::CXXParser parser(lexer);
         DiagnosticPrinter    diag_out;
 
-        parser.addDiagnosticHandler(diag_out);
-        parser.enableDebug(getenv("WR_DEBUG_PARSER") != nullptr);
+        if (prefix_tokens) {
+                lexer.setPrefixTokens(*prefix_tokens);
+        }
 
-        while (input.good()) {
-                wr::parse::SPPFNode::Ptr result
-                                         = parser.parse(parser.declaration);
-                if (result) {
-                        wr::uout << *result << std::endl;
-                        size_t token_count = 0;
-                        for (auto *t = result->firstToken(); t; t = t->next()) {
-                                ++token_count;
-                        }
+        if (parse_threads) {
+                if (parse_profile) {
+                        wr::print(wr::uerr, "%s: warning: -fprofile-parser "
+                                  "ignored with -fparallel-parse\n",
+                                  prog_name);
+                        parse_profile.reset();
                 }
+                status = parseParallel(lexer, options, status);
+                return input.bad() ? EXIT_FAILURE : status;
+        }
 
-                if (parser.errorCount()) {
-                        status = EXIT_FAILURE;
-                        parser.reset();
-                }
+        if (parse_profile) {
+                parser.setProfile(parse_profile.get());
+        }
+
+        wr::parse::ParseMemo memo(parse_memo_budget);
+
+        if (parse_memo_budget) {
+                parser.setMemo(&memo);
+        }
 
-                lexer.clearStorage();
+        if (disambiguate) {
+                parser.addStandardFilters();
+        }
+
+        parser.addDiagnosticHandler(diag_out);
+        parser.enableDebug(getenv("WR_DEBUG_PARSER") != nullptr);
+
+        auto print = [](const wr::parse::SPPFNode &declaration) {
+                outputStream() << declaration << std::endl;
+                return true;
+        };
+
+        if (parser.parseDeclarations(lexer, print)) {
+                status = EXIT_FAILURE;
         }
 
         if (input.bad()) {
                 status = EXIT_FAILURE;
         }
 
+        for (auto &filter: parser.filters()) {
+                printFilterCounts(filter);
+        }
+
+        if (parse_memo_budget) {
+                memo.report(errorStream());
+        }
+
         return status;
 }
 
-int main(int argc, const char **argv) { return run(argc, argv, &parseCXX); }
+//--------------------------------------
+
+int
+main(
+        int          argc,
+        const char **argv
+)
+{
+        int status = run(argc, argv, &parseCXX, false);
+
+        if (parse_profile) {
+                parse_profile->report(wr::uerr);
+        }
+
+        return status;
+}
@@ -0,0 +1,102 @@
+/**
+ * \file AuxArena.h
+ *
+ * \brief Per-parser arena for auxiliary data
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_AUX_ARENA_H
+#define WRPARSECXX_AUX_ARENA_H
+
+#include <stddef.h>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Bump allocator for the auxiliary data attached to SPPF nodes
+ *
+ * The parser annotates every candidate \c decl_specifier_seq, declarator
+ * and declarator part it completes, including the many later discarded;
+ * allocating these individually from the heap is costly. An arena instead
+ * hands out space from large chunks and never frees objects individually:
+ * each chunk counts the objects still alive in it, and once none remain the
+ * chunk is reused from its start. An object kept alive thus holds only its
+ * own chunk. release() returns every chunk holding no objects to the heap,
+ * except the one in use.
+ *
+ * Objects are placed in an arena by deriving from ArenaAllocated and
+ * creating them with <code>new (arena) T</code>. Each records its chunk, so
+ * it may be destroyed through an ordinary intrusive pointer, even after the
+ * arena itself has been destroyed (the memory is then freed along with the
+ * last object). An arena is not thread-safe.
+ */
+class WRPARSECXX_API AuxArena
+{
+public:
+        using this_t = AuxArena;
+
+        AuxArena(size_t chunk_bytes = 16384);
+        AuxArena(const this_t &) = delete;
+
+        ~AuxArena();
+
+        this_t &operator=(const this_t &) = delete;
+
+        void *allocate(size_t bytes);
+        static void deallocate(void *object);
+
+        this_t &release();
+
+        size_t live() const;      ///< objects not yet destroyed
+        size_t capacity() const;  ///< bytes held in chunks
+
+private:
+        struct Header;
+        struct Pool;
+
+        Pool *pool_;  /**< outlives \c *this if objects remain when
+                           destroyed */
+};
+
+
+/**
+ * \brief Base for classes whose objects are allocated from an AuxArena
+ */
+class WRPARSECXX_API ArenaAllocated
+{
+public:
+        static void *operator new(size_t bytes, AuxArena &arena)
+                { return arena.allocate(bytes); }
+        static void operator delete(void *object, AuxArena &)
+                { AuxArena::deallocate(object); }  // if constructor throws
+        static void operator delete(void *object)
+                { AuxArena::deallocate(object); }
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_AUX_ARENA_H
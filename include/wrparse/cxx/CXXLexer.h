@@ -40,6 +40,9 @@ namespace wr {
 namespace parse {
 
 
+class PrecompiledTokens;
+
+
 class WRPARSECXX_API CXXLexer :
         public Lexer
 {
@@ -60,6 +63,9 @@ public:
         bool isValidInitialIdentChar(char32_t c) const;
         bool nextClosingTokenIs(TokenKind k) const;
 
+        this_t &setPrefixTokens(const PrecompiledTokens &prefix);
+        const PrecompiledTokens *prefixTokens() const { return prefix_; }
+
         virtual this_t &clearStorage() override;
 
 protected:
@@ -88,6 +94,7 @@ private:
         void ppDirective(Token &t);
         void pushClosingToken(TokenKind k);
         bool popClosingTokenIf(TokenKind k);
+        void addPrefixIdentifiers();
 
 
         const CXXOptions             &options_;
@@ -96,6 +103,9 @@ private:
         std::forward_list<TokenKind>  closing_tokens_;
                 /**< stack of expected matching closing token kind(s) to match
                      "opening" tokens \c "(", \c "{", \c "[" and \c "<" */
+        const PrecompiledTokens      *prefix_     = nullptr;
+        size_t                        prefix_pos_ = 0;
+                /**< replayed ahead of input, see setPrefixTokens() */
 };
 
 
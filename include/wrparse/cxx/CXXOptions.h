@@ -110,6 +110,25 @@ enum : uint64_t
                              standard from C99 and in C++ */
         NO_PP_DIRECTIVES = UINT64_C(1) << 12,
                         ///< Lexer: do not interpret preprocessor directives
+        LONE_OPERAND_FAST_PATH = UINT64_C(1) << 13,
+                        /**< Parser: bypass the binary operator precedence
+                             chain for operands consisting of a lone
+                             identifier or literal; binary expressions still
+                             take the full chain */
+        SKIP_FUNCTION_BODIES = UINT64_C(1) << 14,
+                        /**< Parser: pass over function bodies, keeping their
+                             tokens for later parsing on demand */
+        FIRST_SET_LOOKAHEAD = UINT64_C(1) << 15,
+                        /**< Parser: reject a nonterminal at once if the next
+                             token cannot begin any of its rules */
+        DEFERRED_ACTIONS = UINT64_C(1) << 16,
+                        /**< Parser: build declarator data, and diagnose
+                             declarators, only for nodes of the final parse
+                             result or on demand */
+        LITERAL_LISTS = UINT64_C(1) << 17,
+                        /**< Parser: read initializer lists of literals in
+                             one pass, keeping their elements for retrieval
+                             rather than parsing each as an expression */
 
         C89_STD_FEATURES = TRIGRAPHS,
         C90_STD_FEATURES = C89_STD_FEATURES,
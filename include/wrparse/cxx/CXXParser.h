@@ -25,10 +25,22 @@
 #ifndef WRPARSECXX_PARSER_H
 #define WRPARSECXX_PARSER_H
 
+#include <bitset>
+#include <forward_list>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <wrparse/SPPF.h>
 #include <wrparse/Grammar.h>
 #include <wrparse/Parser.h>
+#include <wrparse/cxx/AuxArena.h>
 #include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/CXXOptions.h>
+#include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/SkippedBody.h>
+#include <wrparse/cxx/SymbolTable.h>
 
 
 namespace wr {
@@ -36,7 +48,9 @@ namespace parse {
 
 
 class CXXLexer;
-class CXXOptions;
+class LiteralList;
+class ParseMemo;
+class ParseProfile;
 class Token;
 
 
@@ -46,12 +60,22 @@ class WRPARSECXX_API CXXParser:
 public:
         using this_t = CXXParser;
 
+        class Grammar;
+
         CXXParser(const CXXOptions &options);
         CXXParser(const CXXOptions &options, Lexer &lexer);
         CXXParser(CXXLexer &lexer);
 
         virtual ~CXXParser();
 
+        this_t &reset();
+        SPPFNode::Ptr parse(const NonTerminal &nonterminal);
+
+        using DeclarationVisitor = std::function<bool (const SPPFNode &)>;
+
+        size_t parseDeclarations(CXXLexer &lexer,
+                                 const DeclarationVisitor &visit);
+
         static CXXParser &getFrom(ParseState &state)
                 { return static_cast<CXXParser &>(state.parser()); }
 
@@ -59,6 +83,52 @@ public:
                 // specialized in CXXParser.cxx for various data structures
 
         const CXXOptions &options() const { return options_; }
+        const Grammar &grammar() const    { return *grammar_; }
+
+        SymbolTable &symbols()             { return symbols_; }
+        const SymbolTable &symbols() const { return symbols_; }
+
+        this_t &setProfile(ParseProfile *profile);
+        ParseProfile *profile() const { return profile_; }
+
+        this_t &setMemo(ParseMemo *memo);
+        ParseMemo *memo() const { return memo_; }
+
+        /**
+         * \brief Disambiguation filter applied as a nonterminal completes
+         *
+         * \c compare is given a newly-completed derivation of
+         * \c nonterminal and an earlier one spanning the same tokens (both
+         * packed nodes of the one nonterminal node), and returns a positive
+         * value if the new derivation is to be preferred, negative if the
+         * earlier one is, or zero if it cannot choose.
+         */
+        struct Filter
+        {
+                using Compare = int (*)(CXXParser &cxx, const SPPFNode &added,
+                                        const SPPFNode &earlier);
+
+                const char        *name;
+                const NonTerminal *nonterminal;
+                Compare            compare;
+                uint64_t           examined   = 0;  ///< ambiguities compared
+                uint64_t           discarded  = 0;  /**< derivations rejected
+                                                         by filter */
+                uint64_t           unresolved = 0;  /**< preferred derivation
+                                                         completed after the
+                                                         other was kept */
+        };
+
+        this_t &addFilter(const char *name, const NonTerminal &nonterminal,
+                          Filter::Compare compare);
+        this_t &addStandardFilters();
+        const std::vector<Filter> &filters() const { return filters_; }
+
+        SkippedBody *skippedBody(const SPPFNode &function_body) const;
+        this_t &clearSkippedBodies();
+
+        LiteralList *literalList(const SPPFNode &braced_init_list) const;
+        this_t &clearLiteralLists();
 
         static uint8_t qualifierForToken(const Token &token);
 
@@ -66,7 +136,372 @@ public:
                 typeQualifiersFromSeq(const SPPFNode &type_qualifier_seq);
 
 private:
-        const CXXOptions &options_;
+        const CXXOptions               &options_;
+        std::shared_ptr<const Grammar>  grammar_;  ///< may be shared
+        SymbolTable                     symbols_;  /**< names declared so far,
+                                                        consulted by name
+                                                        predicates */
+        ParseProfile                   *profile_ = nullptr;
+        ParseMemo                      *memo_    = nullptr;
+        AuxArena                        aux_arena_;  /**< DeclSpecifier,
+                                                          Declarator and
+                                                          DeclaratorPart
+                                                          data */
+
+        std::vector<Filter> filters_;
+
+        std::unordered_map<size_t, std::unique_ptr<SkippedBody>>
+                            skipped_bodies_;  ///< keyed by offset of '{'
+        std::unordered_map<size_t, std::unique_ptr<LiteralList>>
+                            literal_lists_;  /**< keyed by offset of
+                                                  TOK_LITERAL_LIST */
+        std::forward_list<std::string>
+                            collapsed_;  /**< spellings of collapsed
+                                              balanced-token-seqs */
+
+public:
+        bool langC() const    { return options_.c() != 0; }
+        bool stdC99() const   { return options_.c() >= cxx::C99; }
+        bool stdC11() const   { return options_.c() >= cxx::C11; }
+        bool langCXX() const  { return options_.cxx() != 0; }
+        bool stdCXX11() const { return options_.cxx() >= cxx::CXX11; }
+        bool stdCXX14() const { return options_.cxx() >= cxx::CXX14; }
+        bool stdCXX17() const { return options_.cxx() >= cxx::CXX17; }
+
+        /**
+         * \brief Bit values representing \c const, \c volatile, \c restrict
+         *      and reference qualifiers
+         */
+        enum: uint8_t
+        {
+                CONST    = 0x1,
+                VOLATILE = 0x2,
+                RESTRICT = 0x4,
+                ATOMIC   = 0x8,
+                LVAL_REF = 0x40,  // functions only
+                RVAL_REF = 0x80,  // ditto
+        };
+
+        /**
+         * \brief Base of the data the parser attaches to nodes, tagged with
+         *      its type so that get() need not use \c dynamic_cast
+         *
+         * The parser owns the auxiliary data of the nonterminals it
+         * annotates; API users hang their own data on \c user_data.
+         */
+        class WRPARSECXX_API AuxBase : public AuxData, public ArenaAllocated
+        {
+        public:
+                enum Kind : uint8_t
+                {
+                        DECL_SPECIFIER,
+                        DECLARATOR,
+                        DECLARATOR_PART
+                };
+
+                const Kind aux_kind;
+
+        protected:
+                AuxBase(Kind kind) : aux_kind(kind) {}
+        };
+
+        /**
+         * \brief Data attached to \c decl_specifier_seq nonterminals plus the
+         *      similar nonterminals \c trailing_type_specifier_seq and
+         *      \c type_specifier_seq
+         */
+        class DeclSpecifier : public AuxBase
+        {
+        public:
+                using this_t = DeclSpecifier;
+                using Ptr = boost::intrusive_ptr<this_t>;
+
+                static const Kind KIND = DECL_SPECIFIER;
+
+                DeclSpecifier() : AuxBase(KIND) {}
+
+                uint8_t type_qual = 0;  /**< \c const, \c volatile, \c restrict
+                                             and/or \c _Atomic (but not & or &&)
+                                             qualifier(s) */
+
+                enum Sign: uint8_t { NO_SIGN = 0, SIGNED, UNSIGNED }
+                        sign_spec = NO_SIGN;  /**< \c signed / \c unsigned
+                                                 specifiers for \c char / \c int
+                                                 types only */
+
+                enum Size: uint8_t { NO_SIZE = 0, SHORT, LONG, LONG_LONG }
+                        size_spec = NO_SIZE;  /**< \c short, \c long and
+                                                   \c {long long} specifiers for
+                                                   \c int and \c double only */
+
+                enum Type: uint8_t { NO_TYPE = 0, VOID, AUTO, DECLTYPE, BOOL,
+                                     CHAR, CHAR16_T, CHAR32_T, WCHAR_T, INT,
+                                     FLOAT, DOUBLE, NULLPTR_T, OTHER }
+                        type_spec = NO_TYPE;  ///< core type specifier present
+
+                SPPFNode::ConstPtr sign_spec_node,
+                                   size_spec_node,
+                                   type_spec_node;
+
+                AuxData::Ptr user_data;
+                                ///< for API users to hang extra data on
+        private:
+                friend CXXParser;
+
+                static bool end(ParseState &state);  // nonterminal callback
+
+                bool addDeclSpecifier(CXXParser &cxx, const SPPFNode &spec);
+                        // helper for end()
+        };
+
+
+        /**
+         * \brief Data attached to \c declarator, \c nested_declarator,
+         *      \c abstract_declarator, \c nested_abstract_declarator,
+         *      \c new_declarator, \c conversion_declarator and
+         *      \c lambda_declarator nonterminals
+         */
+        class WRPARSECXX_API Declarator : public AuxBase
+        {
+        public:
+                using this_t = Declarator;
+                using Ptr = boost::intrusive_ptr<this_t>;
+
+                static const Kind KIND = DECLARATOR;
+
+                Declarator() : AuxBase(KIND) {}
+
+                const Token *last_ptr    = nullptr, /**< last \c *, \c X::*,
+                                                         \c & or \c && part */
+                            *begin_parms = nullptr; /**< start of function
+                                                         parameter list */
+                bool         array       = false;   /**< \c true if declarator
+                                                         ends with array */
+                AuxData::Ptr user_data;  /**< for API users to hang
+                                              extra data on */
+
+                static const SPPFNode *lastPtrOperator(CXXParser &cxx,
+                                                      const SPPFNode &dcl_node);
+
+                static bool isReference(CXXParser &cxx,
+                                        const SPPFNode &dcl_node);
+
+        private:
+                friend CXXParser;
+
+                // predicates
+                static bool isFunction(ParseState &state);
+
+                // nonterminal callbacks
+                static bool end(ParseState &state);
+
+                // final checks and settings
+                bool check(CXXParser &cxx, const SPPFNode &dcl_node,
+                           ParseState *state, bool diagnose);
+
+                static Ptr build(CXXParser &cxx, const SPPFNode &dcl_node,
+                                 bool diagnose);  // cxx::DEFERRED_ACTIONS
+        };
+
+        friend Declarator;
+
+
+        /**
+         * \brief Data attached to \c ptr_operator and
+         *      \c parameter_declaration_clause nonterminals
+         */
+        class WRPARSECXX_API DeclaratorPart : public AuxBase
+        {
+        public:
+                using this_t = DeclaratorPart;
+                using Ptr = boost::intrusive_ptr<this_t>;
+
+                static const Kind KIND = DECLARATOR_PART;
+
+                DeclaratorPart() : AuxBase(KIND) {}
+
+                unsigned short count      = 0;      /**< no. of function
+                                                         parameters */
+                bool           variadic   = false;  /**< whether parameter list
+                                                         ends with \c ... */
+                uint8_t        qualifiers = 0;      /**< \c const, \c volatile,
+                                                         \c restrict and/or
+                                                         ref-qualifier(s) */
+                AuxData::Ptr   user_data;  /**< for API users to hang
+                                                extra data on */
+
+                static bool isParmPackOperator(CXXParser &cxx,
+                                               const SPPFNode &part);
+
+        private:
+                friend CXXParser;
+
+                // nonterminal callbacks
+                static bool endPtrOperator(ParseState &state);
+                static bool endParametersAndQualifiers(ParseState &state);
+
+                // helpers for the above and for cxx::DEFERRED_ACTIONS
+                static Ptr forPtrOperator(CXXParser &cxx,
+                                          const SPPFNode &part);
+                static Ptr forParametersAndQualifiers(CXXParser &cxx,
+                                                      const SPPFNode &part);
+                static Ptr build(CXXParser &cxx, const SPPFNode &part);
+        };
+
+private:
+        // predicates
+        static bool isTypedefName(ParseState &state);
+        static bool isClassName(ParseState &state);
+        static bool isEnumName(ParseState &state);
+        static bool isNamespaceName(ParseState &state);
+        static bool isNamespaceAliasName(ParseState &state);
+        static bool isTemplateName(ParseState &state);
+        static bool isUndeclaredName(ParseState &state);
+        static bool isFinalSpecifier(ParseState &state);
+        static bool isBalancedToken(ParseState &state);
+        static bool isSimpleOperand(ParseState &state);
+        static bool isCompoundOperand(ParseState &state);
+        static bool skipFunctionBody(ParseState &state);
+        static bool collapseBalancedTokens(ParseState &state);
+        static bool collapseLiteralList(ParseState &state);
+        static bool isClassHeadName(ParseState &state);
+        static bool processTemplParmArgListEndToken(ParseState &state);
+
+        const SymbolTable::Symbol *lookupName(const Token &name,
+                                              uint8_t kinds) const;
+
+        // symbol table maintenance (nonterminal callbacks)
+        static bool declareNames(ParseState &state);
+        static bool declareName(ParseState &state);
+        static bool declareTemplateParameter(ParseState &state);
+        static bool endScope(ParseState &state);
+        static bool checkPrimaryExpression(ParseState &state);
+
+        void enterDeclaredNames(const SPPFNode &node);
+        void enterDeclaredName(const SPPFNode &node);
+        void enterTemplateParameter(const SPPFNode &node);
+        void closeScopeOf(const SPPFNode &node);
+        void redeclare(const SPPFNode &root);
+
+        // lookahead (nonterminal callback)
+        static bool checkFirstSet(ParseState &state);
+
+        void useGrammar(uint8_t hooks);
+        void runDeferredActions(const SPPFNode &root);
+
+        // memoization (see setMemo())
+        bool recall(ParseState &state, bool &accepted);
+        void remember(ParseState &state, const AuxData::Ptr &aux,
+                      bool accepted);
+
+        // disambiguation
+        static bool applyFilters(ParseState &state);
+        static int preferDeclaration(CXXParser &cxx, const SPPFNode &added,
+                                     const SPPFNode &earlier);
+        static int preferLongestDeclarator(CXXParser &cxx,
+                                           const SPPFNode &added,
+                                           const SPPFNode &earlier);
+        static int preferTypeId(CXXParser &cxx, const SPPFNode &added,
+                                const SPPFNode &earlier);
+
+        // profiling (nonterminal callbacks)
+        static bool profileEnter(ParseState &state);
+        static bool profileLeave(ParseState &state);
+};
+
+
+//--------------------------------------
+
+/**
+ * \brief The C/C++ grammar for one set of language options
+ *
+ * A grammar is not modified once constructed, so one instance may be shared
+ * by any number of parsers, including parsers on different threads; all
+ * per-parse state (symbol table, filters, profile and so on) is held by the
+ * CXXParser. get() returns the shared instance for a configuration,
+ * building it on first request.
+ *
+ * Only the nonterminals that can take part in a parse with the grammar's
+ * options are live: those enabled, reachable from \c translation_unit and
+ * able to derive something through enabled rules. nonTerminals() lists
+ * these, and the rest are ignored by everything built on the grammar, so
+ * for example a pure C grammar carries no C++-only nonterminals.
+ *
+ * The FIRST set of each live nonterminal and of each of its usable rules,
+ * the token kinds that can begin it, is computed along with the live set.
+ * With the \c cxx::FIRST_SET_LOOKAHEAD feature a parser rejects a
+ * nonterminal as soon as it is entered if the next token is not in its
+ * FIRST set, so none of its rules are attempted.
+ *
+ * The actions maintaining the parser's symbol table and auxiliary data are
+ * always registered. The actions needed only for profiling or for
+ * disambiguation filters are registered with every live nonterminal if
+ * requested by \c hooks, so grammars without them pay nothing for them.
+ */
+class WRPARSECXX_API CXXParser::Grammar
+{
+public:
+        using this_t = Grammar;
+        using Ptr    = std::shared_ptr<const this_t>;
+
+        /**
+         * \brief Optional actions registered with every live nonterminal
+         */
+        enum Hooks : uint8_t
+        {
+                NO_HOOKS  = 0,
+                PROFILING = 0x1,  ///< profileEnter() and profileLeave()
+                FILTERING = 0x2   ///< applyFilters()
+        };
+
+        Grammar(const CXXOptions &options, uint8_t hooks = NO_HOOKS);
+        Grammar(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        static Ptr get(const CXXOptions &options, uint8_t hooks = NO_HOOKS);
+
+        const CXXOptions &options() const { return options_; }
+        uint8_t hooks() const             { return hooks_; }
+
+        const std::vector<const NonTerminal *> &nonTerminals() const
+                { return nonterminals_; }
+        const NonTerminal *find(const char *name) const;
+        size_t deadRules() const { return dead_rules_; }
+
+        /**
+         * \brief Token kinds that can begin a nonterminal or rule
+         */
+        struct FirstSet
+        {
+                std::bitset<cxx::TOK_CXX_END> tokens;  /**< all set if a
+                                                            predicate may
+                                                            rewrite the first
+                                                            token */
+                bool                          nullable = false;
+                                                /**< can also derive an
+                                                     empty sequence */
+
+                bool admits(const Token &token) const
+                        { return nullable || (token.kind() >= tokens.size())
+                                 || tokens.test(token.kind()); }
+        };
+
+        const FirstSet *first(const NonTerminal &nonterminal) const;
+        const FirstSet *first(const Rule &rule) const;
+
+private:
+        void prune();
+        void computeFirstSets();
+
+        const CXXOptions                 options_;
+        uint8_t                          hooks_;
+        std::vector<const NonTerminal *> nonterminals_;  ///< see prune()
+        size_t                           dead_rules_ = 0;
+        std::unordered_map<const NonTerminal *, FirstSet>
+                                         nonterminal_first_;
+        std::unordered_map<const Rule *, FirstSet>
+                                         rule_first_;  ///< usable rules only
 
 public:
         /*
@@ -346,156 +781,10 @@ public:
         bool stdCXX11() const { return options_.cxx() >= cxx::CXX11; }
         bool stdCXX14() const { return options_.cxx() >= cxx::CXX14; }
         bool stdCXX17() const { return options_.cxx() >= cxx::CXX17; }
-
-        /**
-         * \brief Bit values representing \c const, \c volatile, \c restrict
-         *      and reference qualifiers
-         */
-        enum: uint8_t
-        {
-                CONST    = 0x1,
-                VOLATILE = 0x2,
-                RESTRICT = 0x4,
-                ATOMIC   = 0x8,
-                LVAL_REF = 0x40,  // functions only
-                RVAL_REF = 0x80,  // ditto
-        };
-
-        /**
-         * \brief Data attached to \c decl_specifier_seq nonterminals plus the
-         *      similar nonterminals \c trailing_type_specifier_seq and
-         *      \c type_specifier_seq
-         */
-        class DeclSpecifier : public AuxData
-        {
-        public:
-                using this_t = DeclSpecifier;
-                using Ptr = boost::intrusive_ptr<this_t>;
-
-                uint8_t type_qual = 0;  /**< \c const, \c volatile, \c restrict
-                                             and/or \c _Atomic (but not & or &&)
-                                             qualifier(s) */
-
-                enum Sign: uint8_t { NO_SIGN = 0, SIGNED, UNSIGNED }
-                        sign_spec = NO_SIGN;  /**< \c signed / \c unsigned
-                                                 specifiers for \c char / \c int
-                                                 types only */
-
-                enum Size: uint8_t { NO_SIZE = 0, SHORT, LONG, LONG_LONG }
-                        size_spec = NO_SIZE;  /**< \c short, \c long and
-                                                   \c {long long} specifiers for
-                                                   \c int and \c double only */
-
-                enum Type: uint8_t { NO_TYPE = 0, VOID, AUTO, DECLTYPE, BOOL,
-                                     CHAR, CHAR16_T, CHAR32_T, WCHAR_T, INT,
-                                     FLOAT, DOUBLE, NULLPTR_T, OTHER }
-                        type_spec = NO_TYPE;  ///< core type specifier present
-
-                SPPFNode::ConstPtr sign_spec_node,
-                                   size_spec_node,
-                                   type_spec_node;
-
-                AuxData::Ptr user_data;
-                                ///< for API users to hang extra data on
-        private:
-                friend CXXParser;
-
-                static bool end(ParseState &state);  // nonterminal callback
-
-                bool addDeclSpecifier(CXXParser &cxx, const SPPFNode &spec);
-                        // helper for end()
-        };
-
-
-        /**
-         * \brief Data attached to \c declarator, \c nested_declarator,
-         *      \c abstract_declarator, \c nested_abstract_declarator,
-         *      \c new_declarator, \c conversion_declarator and
-         *      \c lambda_declarator nonterminals
-         */
-        class WRPARSECXX_API Declarator : public AuxData
-        {
-        public:
-                using this_t = Declarator;
-                using Ptr = boost::intrusive_ptr<this_t>;
-
-                const Token *last_ptr    = nullptr, /**< last \c *, \c X::*,
-                                                         \c & or \c && part */
-                            *begin_parms = nullptr; /**< start of function
-                                                         parameter list */
-                bool         array       = false;   /**< \c true if declarator
-                                                         ends with array */
-                AuxData::Ptr user_data;  /**< for API users to hang
-                                              extra data on */
-
-                static const SPPFNode *lastPtrOperator(CXXParser &cxx,
-                                                      const SPPFNode &dcl_node);
-
-                static bool isReference(CXXParser &cxx,
-                                        const SPPFNode &dcl_node);
-
-        private:
-                friend CXXParser;
-
-                // predicates
-                static bool isFunction(ParseState &state);
-
-                // nonterminal callbacks
-                static bool end(ParseState &state);
-
-                // final checks and settings
-                bool check(ParseState &state, CXXParser &cxx,
-                           const SPPFNode &dcl_node);
-        };
-
-        friend Declarator;
-
-
-        /**
-         * \brief Data attached to \c ptr_operator and
-         *      \c parameter_declaration_clause nonterminals
-         */
-        class WRPARSECXX_API DeclaratorPart : public AuxData
-        {
-        public:
-                using this_t = DeclaratorPart;
-                using Ptr = boost::intrusive_ptr<this_t>;
-
-                unsigned short count      = 0;      /**< no. of function
-                                                         parameters */
-                bool           variadic   = false;  /**< whether parameter list
-                                                         ends with \c ... */
-                uint8_t        qualifiers = 0;      /**< \c const, \c volatile,
-                                                         \c restrict and/or
-                                                         ref-qualifier(s) */
-                AuxData::Ptr   user_data;  /**< for API users to hang
-                                                extra data on */
-
-                static bool isParmPackOperator(CXXParser &cxx,
-                                               const SPPFNode &part);
-
-        private:
-                friend CXXParser;
-
-                // nonterminal callbacks
-                static bool endPtrOperator(ParseState &state);
-                static bool endParametersAndQualifiers(ParseState &state);
-        };
-
-private:
-        // predicates
-        static bool isTypedefName(ParseState &state);
-        static bool isClassName(ParseState &state);
-        static bool isEnumName(ParseState &state);
-        static bool isNamespaceName(ParseState &state);
-        static bool isNamespaceAliasName(ParseState &state);
-        static bool isTemplateName(ParseState &state);
-        static bool isUndeclaredName(ParseState &state);
-        static bool isFinalSpecifier(ParseState &state);
-        static bool isBalancedToken(ParseState &state);
-        static bool processTemplParmArgListEndToken(ParseState &state);
 };
 
+using CXXGrammar = CXXParser::Grammar;
+
 
 } // namespace parse
 
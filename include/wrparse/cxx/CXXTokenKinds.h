@@ -237,6 +237,15 @@ enum : TokenKind
         TOK_PP_NULL,
         /* revise isPreprocessorToken() / isPreprocessorDirective()
            if preprocessor tokens added after TOK_PP_NULL */
+
+        /*
+         * synthesised by the parser rather than lexed
+         */
+        TOK_SKIPPED_BODY,  ///< function body, see CXXParser::skippedBody()
+        TOK_BALANCED_TOKEN_SEQ,  ///< attribute arguments read in one pass
+        TOK_LITERAL_LIST,  ///< initializer list elements, see LiteralList
+
+        TOK_CXX_END  ///< one greater than the last C/C++ token ID; not a token
 };
 
 //--------------------------------------
@@ -0,0 +1,106 @@
+/**
+ * \file DeclSplitter.h
+ *
+ * \brief Splitting of input into top-level declarations
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_DECL_SPLITTER_H
+#define WRPARSECXX_DECL_SPLITTER_H
+
+#include <memory>
+#include <vector>
+#include <wrparse/Lexer.h>
+#include <wrparse/Token.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/SymbolTable.h>
+#include <wrparse/cxx/TokenRun.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Divides a translation unit into independently parsable
+ *      top-level declarations
+ *
+ * split() reads all tokens from a lexer and cuts them at each \c ";" or
+ * closing \c "}" of a function body found outside any bracket. Namespace
+ * and linkage-specification braces are treated as split points themselves:
+ * their opening and closing tokens are dropped, so each declaration within
+ * becomes a run of its own. Each run may then be parsed by a separate
+ * parser, e.g. on a worker thread, with \c CXXParser::declaration as the
+ * start symbol.
+ *
+ * Since such parsers cannot see names declared in earlier runs, the
+ * splitter also enters the names that each run evidently declares (class,
+ * enumeration, namespace, typedef and alias names, templates, and the first
+ * declarator of other declarations) in names(); use it as the parent of
+ * each parser's own symbol table. Lookups in that table are by source
+ * offset, so each run only sees names declared before it regardless of the
+ * order in which runs are parsed.
+ */
+class WRPARSECXX_API DeclSplitter
+{
+public:
+        using this_t = DeclSplitter;
+        using Runs   = std::vector<std::unique_ptr<TokenRun>>;
+
+        DeclSplitter(Lexer &lexer);
+        DeclSplitter(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        size_t split();
+
+        Runs &runs()                     { return runs_; }
+        const Runs &runs() const         { return runs_; }
+        const SymbolTable &names() const { return names_; }
+
+private:
+        enum Close : uint8_t
+        {
+                AT_SEMI,   ///< run ends at next top-level ';'
+                AT_BRACE   ///< run ends at '}' closing current top-level '{'
+        };
+
+        bool opensScope() const;
+        Close braceCloses() const;
+        const Token *groupDeclaratorId() const;
+        void declareNames();
+        void endRun();
+
+        Lexer              &lexer_;
+        Runs                runs_;
+        SymbolTable         names_;
+        std::vector<Token>  top_;    /**< tokens of current run outside any
+                                          bracket */
+        std::vector<Token>  group_;  /**< tokens directly within the current
+                                          run's first top-level parentheses,
+                                          up to the closing ')' */
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_DECL_SPLITTER_H
@@ -26,6 +26,8 @@
 #define WRPARSECXX_EXPR_MATCH_H
 
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 #include <wrparse/cxx/Config.h>
 #include <wrparse/cxx/CXXParser.h>
 
@@ -90,7 +92,9 @@ struct Literal
         };
 
 
+        Literal() : u(0) {}  ///< leaves type unset
         WRPARSECXX_API Literal(CXXParser &cxx, const SPPFNode &input);
+        WRPARSECXX_API explicit Literal(const Token &input);
         WRPARSECXX_API Literal(CXXParser &cxx, const SPPFNode &input,
                                ExprType convert_to_type);
         WRPARSECXX_API Literal(const Literal &other) = default;
@@ -105,9 +109,113 @@ private:
 
 //--------------------------------------
 
+/**
+ * \brief Folds constant expressions parsed by CXXParser
+ *
+ * Evaluates literals, the unary operators <tt>+ - ! ~</tt>, the binary
+ * arithmetic, shift, bitwise, relational, equality and logical operators,
+ * the conditional and comma operators, casts to arithmetic types and
+ * \c sizeof applied to an arithmetic type or to a foldable expression,
+ * applying the usual arithmetic conversions. Names are not looked up, so
+ * an expression referring to a variable, enumerator or template parameter
+ * cannot be folded. Type sizes are those of the host; signed overflow
+ * wraps rather than failing.
+ *
+ * Results, failures included, are memoized per SPPFNode so that each
+ * subexpression is folded once however many times it is compared. Nodes
+ * are remembered by address: clear() the evaluator before releasing the
+ * parse results it was used on.
+ */
+class WRPARSECXX_API ConstExprEvaluator
+{
+public:
+        using this_t = ConstExprEvaluator;
+
+        ConstExprEvaluator(CXXParser &cxx);
+        ConstExprEvaluator(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        bool evaluate(const SPPFNode &expr, Literal &value);
+
+        CXXParser &parser() const { return cxx_; }
+        size_t size() const       { return memo_.size(); }  ///< nodes seen
+
+        this_t &clear();
+
+private:
+        using Parts = std::vector<const SPPFNode *>;
+
+        bool fold(const SPPFNode &expr, Literal &value);
+        bool foldUnary(const Parts &parts, Literal &value);
+        bool foldSizeof(const Parts &parts, Literal &value);
+        bool foldCast(const Parts &parts, Literal &value);
+        bool foldBinary(const SPPFNode &expr, const Parts &parts,
+                        Literal &value);
+        bool foldConditional(const Parts &parts, Literal &value);
+
+        ExprType typeOf(const SPPFNode &type_id);
+
+        CXXParser                                     &cxx_;
+        std::unordered_map<const SPPFNode *, Literal>  memo_;
+};
+
+//--------------------------------------
+
+/**
+ * \brief Structural hashing of expressions for bulk comparison
+ *
+ * Comparing every pair of a large set of expressions with matchConstExpr()
+ * is quadratic; instead bucket them by hash() and compare only within each
+ * bucket using equivalent(). Subtrees that fold to a constant hash by value,
+ * normalized with Literal::convertType() so that \c 8, \c 010, \c 8L,
+ * \c 8.0 and <tt>2 * 4</tt> hash alike; constants are equivalent only if
+ * their values are mathematically equal, so \c -1 and \c 4294967295u are
+ * not. Any other subtree hashes by its nonterminal's name and the
+ * spellings of its tokens, ignoring redundant parentheses; comments and
+ * whitespace are not tokens so never contribute. As neither depends on
+ * the parser instance, hashes computed through different parsers may be
+ * compared, although equivalent() only accepts nodes from the evaluator's
+ * own parser.
+ *
+ * Hashes are memoized per SPPFNode by address, as are the evaluator's
+ * results, so clear() both before releasing the parse results hashed.
+ */
+class WRPARSECXX_API ExprHasher
+{
+public:
+        using this_t = ExprHasher;
+
+        ExprHasher(ConstExprEvaluator &evaluator);
+        ExprHasher(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        uint64_t hash(const SPPFNode &expr);
+        bool equivalent(const SPPFNode &a, const SPPFNode &b);
+
+        ConstExprEvaluator &evaluator() const { return evaluator_; }
+
+        this_t &clear();
+
+private:
+        using Parts = std::vector<const SPPFNode *>;
+
+        const SPPFNode &unwrap(const SPPFNode &expr, Parts &parts) const;
+
+        ConstExprEvaluator                             &evaluator_;
+        std::unordered_map<const SPPFNode *, uint64_t>  memo_;
+};
+
+//--------------------------------------
+
 WRPARSECXX_API bool matchConstExpr(CXXParser &cxx, SPPFNode::ConstPtr a,
                                    SPPFNode::ConstPtr b, ExprType target_type);
 
+WRPARSECXX_API bool matchConstExpr(ConstExprEvaluator &evaluator,
+                                   SPPFNode::ConstPtr a, SPPFNode::ConstPtr b,
+                                   ExprType target_type);
+
 WRPARSECXX_API bool areEquivalent(const Literal &a, const Literal &b,
                                   ExprType target_type);
 
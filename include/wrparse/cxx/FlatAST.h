@@ -0,0 +1,171 @@
+/**
+ * \file FlatAST.h
+ *
+ * \brief Compact index-based export of a parse forest
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_FLAT_AST_H
+#define WRPARSECXX_FLAT_AST_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wrutil/u8string_view.h>
+#include <wrparse/SPPF.h>
+#include <wrparse/Token.h>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class CXXParser;
+class NonTerminal;
+
+
+/**
+ * \brief Parse results flattened into arrays of fixed-size records
+ *
+ * add() walks a parse result once and appends a record for each of its
+ * terminal and nonterminal nodes in preorder, so that a subtree occupies
+ * the contiguous range of nodes from its root up to \c Node::subtree_end.
+ * Children are linked through indices rather than pointers, tokens are
+ * referred to by index into tokens(), and the \c DeclSpecifier,
+ * \c Declarator and \c DeclaratorPart data the parser attached to a node
+ * are copied into the node itself. Once built, the arrays make no
+ * reference to the parser or the forest, which may then be discarded;
+ * passes over them may run in parallel over disjoint subtrees.
+ *
+ * The forest should be disambiguated first, e.g. with
+ * CXXParser::addStandardFilters(). Of a node still having more than one
+ * derivation, only the first is exported and the node is flagged
+ * \c AMBIGUOUS.
+ */
+class WRPARSECXX_API FlatAST
+{
+public:
+        using this_t = FlatAST;
+
+        static const uint32_t NONE = UINT32_MAX;  ///< no such node or token
+
+        enum Flags : uint8_t
+        {
+                TERMINAL  = 0x1,  ///< \c symbol is a token kind
+                AMBIGUOUS = 0x2   ///< alternative derivations were dropped
+        };
+
+        enum AuxType : uint8_t
+        {
+                NO_AUX = 0,
+                DECL_SPECIFIER,
+                DECLARATOR,
+                DECLARATOR_PART
+        };
+
+        struct Node
+        {
+                uint32_t symbol;        /**< index into nonTerminals(), or
+                                             token kind if \c TERMINAL */
+                uint32_t first_token;   ///< index into tokens()
+                uint32_t end_token;     /**< one past last token; equal to
+                                             \c first_token if empty */
+                uint32_t first_child,
+                         next_sibling,
+                         subtree_end;   ///< one past last descendant
+                uint8_t  flags;
+                uint8_t  aux_type;      ///< which member of \c aux is set
+
+                union
+                {
+                        struct
+                        {
+                                uint8_t type_qual,
+                                        sign_spec,
+                                        size_spec,
+                                        type_spec;
+                        } decl_specifier;  ///< see CXXParser::DeclSpecifier
+
+                        struct
+                        {
+                                uint32_t last_ptr,     ///< token index
+                                         begin_parms;  ///< ditto
+                                bool     array;
+                        } declarator;      ///< see CXXParser::Declarator
+
+                        struct
+                        {
+                                uint16_t count;
+                                uint8_t  qualifiers;
+                                bool     variadic;
+                        } declarator_part; ///< see CXXParser::DeclaratorPart
+                } aux;
+        };
+
+        struct TokenRecord
+        {
+                TokenKind  kind;
+                TokenFlags flags;
+                uint32_t   spelling;  ///< offset into spelling pool
+                uint32_t   length;    ///< spelling length in bytes
+                uint64_t   offset;    ///< source offset
+        };
+
+        FlatAST() = default;
+        FlatAST(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        uint32_t add(CXXParser &cxx, const SPPFNode &root);
+        this_t &clear();
+
+        const std::vector<Node> &nodes() const          { return nodes_; }
+        const std::vector<TokenRecord> &tokens() const  { return tokens_; }
+        const std::vector<uint32_t> &roots() const      { return roots_; }
+
+        const std::vector<const NonTerminal *> &nonTerminals() const
+                { return nonterminals_; }
+        const NonTerminal *nonTerminal(const Node &node) const;
+
+        u8string_view spelling(const TokenRecord &token) const
+                { return { spellings_.data() + token.spelling,
+                           token.length }; }
+        const std::string &spellings() const { return spellings_; }
+
+private:
+        uint32_t symbolFor(const NonTerminal *nonterminal);
+
+        std::vector<Node>                                nodes_;
+        std::vector<TokenRecord>                         tokens_;
+        std::vector<uint32_t>                            roots_;
+        std::vector<const NonTerminal *>                 nonterminals_;
+        std::unordered_map<const NonTerminal *, uint32_t> symbols_;
+                                        ///< index of each in nonterminals_
+        std::string                                      spellings_;
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_FLAT_AST_H
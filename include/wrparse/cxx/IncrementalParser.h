@@ -0,0 +1,116 @@
+/**
+ * \file IncrementalParser.h
+ *
+ * \brief Reparsing of edited source one declaration at a time
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_INCREMENTAL_PARSER_H
+#define WRPARSECXX_INCREMENTAL_PARSER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <wrutil/u8string_view.h>
+#include <wrparse/Diagnostic.h>
+#include <wrparse/SPPF.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/CXXOptions.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class CXXParser;
+class DeclSplitter;
+class TokenRun;
+
+
+/**
+ * \brief Keeps a translation unit parsed while it is being edited
+ *
+ * The source is divided into top-level declarations by a DeclSplitter and
+ * each is parsed by a CXXParser of its own, as when parsing in parallel.
+ * After edit(), the source is relexed and split again, and the new runs of
+ * tokens are compared with those of the previous version: declarations
+ * wholly before or after the edited text whose tokens are unchanged keep
+ * their parse forest, aux data and parser, with token offsets, lines and
+ * columns moved to account for the edit. Only the declarations spanning the
+ * edit are parsed again, together with any later declaration using a name
+ * that the splitter finds was declared, or had been declared, by one of
+ * them.
+ *
+ * Declarations are reparsed as a whole; a member of a class definition is
+ * not reparsed apart from the rest of the class. \c SKIP_FUNCTION_BODIES
+ * and \c LITERAL_LISTS modes are not supported, since skipped bodies and
+ * collapsed literal lists are identified by offset.
+ */
+class WRPARSECXX_API IncrementalParser
+{
+public:
+        using this_t = IncrementalParser;
+
+        IncrementalParser(const CXXOptions &options);
+        IncrementalParser(const this_t &) = delete;
+
+        ~IncrementalParser();
+
+        this_t &operator=(const this_t &) = delete;
+
+        this_t &addDiagnosticHandler(DiagnosticHandler &handler);
+
+        size_t parse(const u8string_view &source);
+        size_t edit(size_t offset, size_t removed,
+                    const u8string_view &inserted);
+
+        const std::string &source() const { return source_; }
+
+        size_t size() const { return units_.size(); }
+        SPPFNode::ConstPtr result(size_t index) const;
+        CXXParser &parser(size_t index) const;
+        size_t beginOffset(size_t index) const;
+        size_t endOffset(size_t index) const;
+
+private:
+        struct Unit;
+
+        using Units = std::vector<std::unique_ptr<Unit>>;
+
+        std::unique_ptr<DeclSplitter> split() const;
+        std::unique_ptr<Unit> parseRun(std::unique_ptr<TokenRun> run,
+                                       const DeclSplitter &splitter) const;
+        bool usesNames(const Unit &unit, const DeclSplitter &splitter,
+                       size_t begin, size_t end, ptrdiff_t delta) const;
+
+        const CXXOptions                 options_;
+        std::vector<DiagnosticHandler *> handlers_;
+        std::string                      source_;
+        std::unique_ptr<DeclSplitter>    splitter_;  /**< names declared in
+                                                          source_ */
+        Units                            units_;     ///< in source order
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_INCREMENTAL_PARSER_H
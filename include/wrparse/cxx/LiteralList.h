@@ -0,0 +1,94 @@
+/**
+ * \file LiteralList.h
+ *
+ * \brief Literal-only initializer lists read in one pass
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_LITERAL_LIST_H
+#define WRPARSECXX_LITERAL_LIST_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <wrutil/u8string_view.h>
+#include <wrparse/Token.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/ExprMatch.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Elements of an initializer list read in \c cxx::LITERAL_LISTS mode
+ *
+ * The parser reads a braced-init-list consisting only of literals in a
+ * single pass, replacing its elements with one \c TOK_LITERAL_LIST token
+ * so that none passes through the expression grammar, and keeps the
+ * elements here, retrievable through CXXParser::literalList(). Each element
+ * is a numeric literal, optionally preceded by \c + or \c -, or a single
+ * character, string or boolean literal. The token's spelling is text(), the
+ * elements' spellings separated by commas.
+ */
+class WRPARSECXX_API LiteralList
+{
+public:
+        using this_t = LiteralList;
+
+        LiteralList() = default;
+        LiteralList(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        this_t &add(const Token &literal, const Token *sign = nullptr);
+
+        size_t size() const { return elements_.size(); }
+        TokenKind kind(size_t index) const { return elements_[index].kind; }
+        u8string_view spelling(size_t index) const;
+        cxx::Literal value(size_t index) const;
+        const std::vector<cxx::Literal> &values();
+
+        u8string_view text() const { return u8string_view(text_); }
+        size_t beginOffset() const { return begin_offset_; }
+        size_t endOffset() const   { return end_offset_; }  ///< past last
+
+private:
+        struct Element
+        {
+                uint32_t  spelling;  ///< offset into text_
+                uint32_t  length;
+                TokenKind kind;
+        };
+
+        std::string               text_;
+        std::vector<Element>      elements_;
+        std::vector<cxx::Literal> values_;  ///< decoded by values()
+        size_t                    begin_offset_ = 0,
+                                  end_offset_   = 0;
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_LITERAL_LIST_H
@@ -0,0 +1,70 @@
+/**
+ * \file MappedFile.h
+ *
+ * \brief Read-only view of a binary file's contents
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_MAPPED_FILE_H
+#define WRPARSECXX_MAPPED_FILE_H
+
+#include <stdint.h>
+#include <vector>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Read-only view of a file's contents
+ *
+ * The file is memory-mapped where the platform supports it, otherwise read
+ * into a heap buffer. Either way the contents are aligned to at least
+ * 8 bytes, so that an image of fixed-size records may be used in place.
+ */
+class WRPARSECXX_API MappedFile
+{
+public:
+        using this_t = MappedFile;
+
+        MappedFile(const char *file_path, const char *description);
+        MappedFile(const this_t &) = delete;
+
+        ~MappedFile();
+
+        this_t &operator=(const this_t &) = delete;
+
+        const char *data() const { return data_; }
+        size_t size() const      { return bytes_; }
+
+private:
+        const char            *data_  = nullptr;
+        size_t                 bytes_ = 0;
+        std::vector<uint64_t>  buffer_;  // 8-byte aligned fallback storage
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_MAPPED_FILE_H
@@ -0,0 +1,149 @@
+/**
+ * \file ParseImage.h
+ *
+ * \brief Binary image of a flattened parse, loadable in place
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_PARSE_IMAGE_H
+#define WRPARSECXX_PARSE_IMAGE_H
+
+#include <stdint.h>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include <wrutil/u8string_view.h>
+#include <wrparse/Diagnostic.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/CXXOptions.h>
+#include <wrparse/cxx/FlatAST.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class MappedFile;
+
+
+/**
+ * \brief Read-only image of the flattened parse of a source file
+ *
+ * An image holds the token table, nodes and root indices of a FlatAST,
+ * the names of the nonterminals its nodes refer to, and the diagnostics
+ * reported while parsing. Images are written by write() and loaded by the
+ * constructor, which maps the file into memory where the platform permits;
+ * nodes() and tokens() then point directly into the mapped image, in the
+ * same layout as FlatAST, so loading costs nothing per node.
+ *
+ * An image records the hash of the source text it was parsed from and the
+ * options it was parsed with. Loading it for different source text or
+ * options fails with \c std::invalid_argument, so that a stale image is
+ * never used in place of parsing the file again.
+ */
+class WRPARSECXX_API ParseImage
+{
+public:
+        using this_t = ParseImage;
+
+        struct DiagnosticRecord
+        {
+                uint32_t category;  ///< \c Diagnostic::Category
+                uint32_t line;
+                uint32_t column;
+                uint32_t text;      ///< offset into string pool
+                uint32_t length;    ///< text length in bytes
+                uint32_t reserved;
+                uint64_t offset;    ///< source offset
+                uint64_t bytes;     ///< length of source text diagnosed
+        };
+
+        /**
+         * \brief Diagnostic handler keeping a copy of each diagnostic for
+         *      write()
+         */
+        class WRPARSECXX_API DiagnosticLog : public DiagnosticHandler
+        {
+        public:
+                virtual void onDiagnostic(const Diagnostic &d) override;
+
+                std::vector<DiagnosticRecord> records;
+                std::string                   texts;
+        };
+
+        ParseImage(const char *file_path, const CXXOptions &options,
+                   uint64_t content_hash);
+        ParseImage(const this_t &) = delete;
+
+        ~ParseImage();
+
+        this_t &operator=(const this_t &) = delete;
+
+        static uint64_t hash(const u8string_view &source);
+
+        static void write(std::ostream &output, const FlatAST &ast,
+                          const DiagnosticLog &diagnostics,
+                          const CXXOptions &options, uint64_t content_hash);
+
+        uint64_t contentHash() const;
+        cxx::Languages languages() const;
+        cxx::Features features() const;
+
+        size_t nodeCount() const;
+        const FlatAST::Node *nodes() const { return nodes_; }
+
+        size_t tokenCount() const;
+        const FlatAST::TokenRecord *tokens() const { return tokens_; }
+        u8string_view spelling(const FlatAST::TokenRecord &token) const;
+
+        size_t rootCount() const;
+        const uint32_t *roots() const { return roots_; }
+
+        size_t nonTerminalCount() const;
+        u8string_view nonTerminalName(size_t index) const;
+        u8string_view nonTerminalName(const FlatAST::Node &node) const;
+
+        size_t diagnosticCount() const;
+        const DiagnosticRecord &diagnostic(size_t index) const;
+        u8string_view text(const DiagnosticRecord &diagnostic) const;
+
+private:
+        struct Header;
+        struct Span;
+
+        u8string_view string(uint32_t offset, uint32_t length) const;
+
+        std::unique_ptr<MappedFile>  mapping_;
+        const Header                *header_;
+        const FlatAST::TokenRecord  *tokens_;
+        const DiagnosticRecord      *diagnostics_;
+        const FlatAST::Node         *nodes_;
+        const uint32_t              *roots_;
+        const Span                  *names_;
+        const char                  *pool_;
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_PARSE_IMAGE_H
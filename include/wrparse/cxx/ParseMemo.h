@@ -0,0 +1,160 @@
+/**
+ * \file ParseMemo.h
+ *
+ * \brief Memo table of completed derivations
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_PARSE_MEMO_H
+#define WRPARSECXX_PARSE_MEMO_H
+
+#include <stdint.h>
+#include <deque>
+#include <iosfwd>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <wrparse/SPPF.h>
+#include <wrparse/Token.h>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class CXXParser;
+class NonTerminal;
+class Token;
+
+
+/**
+ * \brief Memo of derivations completed from each token, bounded in size
+ *
+ * A memo is attached to a parser by CXXParser::setMemo(). While attached,
+ * the actions validating and annotating \c decl_specifier_seq, the similar
+ * type specifier sequences and the declarator nonterminals (those building
+ * \c DeclSpecifier and \c Declarator data) record each derivation they judge
+ * here, keyed by nonterminal and start token. When the parser re-derives the
+ * same nonterminal over the same tokens through the same immediate
+ * sub-derivations, as it does for a \c type_id within <code>sizeof(...)</code>
+ * or a cast explored alongside a parenthesized expression, the earlier
+ * verdict and auxiliary data are reused rather than computed again, and no
+ * diagnostics are repeated.
+ *
+ * Only a summary of each derivation's immediate sub-derivations is kept,
+ * never the SPPF nodes themselves, so memory held is limited to budget()
+ * bytes, approximately; once full, the longest-held start tokens are
+ * forgotten first. Entries refer to tokens by
+ * source offset, so a memo must be cleared before being used for another
+ * input.
+ */
+class WRPARSECXX_API ParseMemo
+{
+public:
+        using this_t = ParseMemo;
+
+        enum : size_t { DEFAULT_BUDGET = size_t(16) << 20 };
+
+        struct Stats
+        {
+                uint64_t hits       = 0;  ///< derivations answered from memo
+                uint64_t misses     = 0;  ///< derivations judged afresh
+                uint64_t evictions  = 0;  ///< start tokens forgotten
+                size_t   bytes      = 0;  ///< approximate memory held
+                size_t   peak_bytes = 0;
+        };
+
+        ParseMemo(size_t budget = DEFAULT_BUDGET);
+        ParseMemo(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        size_t budget() const { return budget_; }
+        this_t &setBudget(size_t budget);
+
+        const Stats &stats() const { return stats_; }
+
+        this_t &clear();
+        this_t &clearDerivations();
+
+        void report(std::ostream &output) const;
+
+private:
+        friend CXXParser;
+
+        struct Part  ///< immediate sub-derivation, see shapeOf()
+        {
+                const NonTerminal *nonterminal;  ///< \c nullptr if a token
+                TokenKind          kind;         ///< kind, if a token
+                size_t             last;         /**< offset of last token,
+                                                      \c SIZE_MAX if empty */
+
+                bool operator==(const Part &r) const
+                        { return (nonterminal == r.nonterminal)
+                                 && (kind == r.kind) && (last == r.last); }
+        };
+
+        struct Entry
+        {
+                size_t            last;   ///< offset of last token
+                size_t            hash;   ///< of shape, compared first
+                std::vector<Part> shape;
+                AuxData::Ptr      aux;
+                bool              accepted;
+        };
+
+        const Entry *recall(const NonTerminal &nonterminal,
+                            const SPPFNode &node);
+        void remember(const NonTerminal &nonterminal, const SPPFNode &node,
+                      const AuxData::Ptr &aux, bool accepted);
+
+        static Part partOf(const SPPFNode &sub);
+        static std::vector<Part> shapeOf(const SPPFNode &node);
+        static size_t hashOf(const SPPFNode &node);
+        static bool sameShape(const std::vector<Part> &shape,
+                              const SPPFNode &node);
+        static size_t bytesOf(const Entry &entry);
+
+        void evict(size_t bytes);
+
+        using Start = std::pair<const NonTerminal *, size_t>;
+                                        // nonterminal, offset of first token
+        struct StartHash
+        {
+                size_t operator()(const Start &start) const
+                {
+                        return std::hash<const void *>()(start.first)
+                                ^ (start.second * 31);
+                }
+        };
+
+        std::unordered_map<Start, std::vector<Entry>, StartHash>  table_;
+        std::deque<Start>  order_;  ///< keys of table_ in order first stored
+        size_t             budget_;
+        Stats              stats_;
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_PARSE_MEMO_H
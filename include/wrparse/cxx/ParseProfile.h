@@ -0,0 +1,116 @@
+/**
+ * \file ParseProfile.h
+ *
+ * \brief Per-nonterminal parse profiling
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_PARSE_PROFILE_H
+#define WRPARSECXX_PARSE_PROFILE_H
+
+#include <stdint.h>
+#include <chrono>
+#include <iosfwd>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class CXXParser;
+class NonTerminal;
+class SPPFNode;
+class Token;
+
+
+/**
+ * \brief Per-nonterminal statistics gathered while parsing
+ *
+ * A profile is attached to a parser by CXXParser::setProfile() and
+ * accumulates over every subsequent parse until cleared. For each nonterminal
+ * it records how often the parser attempted it at some input position, how
+ * often the attempt succeeded, how many SPPF nodes (including packed nodes)
+ * resulted, how many of those were ambiguous and the wall time from each
+ * attempt to its first completion.
+ *
+ * As the GLL parser interleaves work on many nonterminals, times are
+ * inclusive of nested nonterminals and of any other parsing performed in the
+ * meantime; they indicate where the parser spends its effort rather than
+ * giving self times that sum to the total.
+ */
+class WRPARSECXX_API ParseProfile
+{
+public:
+        using this_t = ParseProfile;
+        using clock  = std::chrono::steady_clock;
+
+        struct Entry
+        {
+                const NonTerminal *nonterminal;
+                uint64_t           attempts  = 0;  ///< times parse started
+                uint64_t           successes = 0;  ///< times parse completed
+                uint64_t           nodes     = 0;  /**< SPPF nodes created,
+                                                        including packed */
+                uint64_t           ambiguous = 0;  /**< nodes having more than
+                                                        one packed node */
+                clock::duration    time      = clock::duration::zero();
+        };
+
+        this_t &clear();
+
+        std::vector<Entry> entries() const;  // sorted by descending time
+
+        void report(std::ostream &output, size_t limit = SIZE_MAX) const;
+
+private:
+        friend CXXParser;
+
+        void enter(const NonTerminal &nonterminal, const Token *input);
+        void leave(const NonTerminal &nonterminal, const Token *input,
+                   const SPPFNode *result);
+        void finish();
+
+        using Attempt = std::pair<const NonTerminal *, const Token *>;
+
+        struct AttemptHash
+        {
+                size_t operator()(const Attempt &attempt) const
+                {
+                        return std::hash<const void *>()(attempt.first)
+                                ^ (std::hash<const void *>()(attempt.second)
+                                   * 31);
+                }
+        };
+
+        std::unordered_map<const NonTerminal *, Entry>  stats_;
+        std::unordered_map<Attempt, clock::time_point, AttemptHash>
+                                                         pending_;
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_PARSE_PROFILE_H
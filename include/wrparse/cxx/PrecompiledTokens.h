@@ -0,0 +1,103 @@
+/**
+ * \file PrecompiledTokens.h
+ *
+ * \brief Precompiled token image of a common prefix header
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_PRECOMPILED_TOKENS_H
+#define WRPARSECXX_PRECOMPILED_TOKENS_H
+
+#include <iosfwd>
+#include <memory>
+#include <wrutil/u8string_view.h>
+#include <wrparse/Token.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/CXXOptions.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class CXXLexer;
+class MappedFile;
+
+
+/**
+ * \brief Read-only token image of a prefix header
+ *
+ * A precompiled token image holds the complete token sequence produced by
+ * lexing a prefix header (typically one including the standard library and
+ * framework headers common to every translation unit) together with its
+ * identifier table. Images are written by write() and loaded by the
+ * constructor, which maps the file into memory where the platform permits;
+ * token spellings then refer directly into the mapped image so replaying
+ * the prefix through CXXLexer::setPrefixTokens() copies no text.
+ *
+ * An image is only usable with the exact language and feature set it was
+ * built with. Loading an image built with different CXXOptions fails with
+ * \c std::invalid_argument.
+ */
+class WRPARSECXX_API PrecompiledTokens
+{
+public:
+        using this_t = PrecompiledTokens;
+
+        PrecompiledTokens(const char *file_path, const CXXOptions &options);
+        PrecompiledTokens(const this_t &) = delete;
+
+        ~PrecompiledTokens();
+
+        this_t &operator=(const this_t &) = delete;
+
+        static void write(std::ostream &output, CXXLexer &lexer);
+
+        cxx::Languages languages() const;
+        cxx::Features features() const;
+        bool compatibleWith(const CXXOptions &options) const;
+
+        size_t size() const;  ///< number of tokens in image
+        size_t sourceBytes() const;
+        Token &get(size_t index, Token &token) const;
+
+        size_t identifierCount() const;
+        u8string_view identifier(size_t index) const;
+
+private:
+        struct Header;
+        struct Record;
+        struct Span;
+
+        u8string_view spelling(uint32_t offset, uint32_t length) const;
+
+        std::unique_ptr<MappedFile>  mapping_;
+        const Header                *header_;
+        const Record                *records_;
+        const Span                  *identifiers_;
+        const char                  *pool_;
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_PRECOMPILED_TOKENS_H
@@ -0,0 +1,66 @@
+/**
+ * \file SkippedBody.h
+ *
+ * \brief Function bodies passed over by the parser
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_SKIPPED_BODY_H
+#define WRPARSECXX_SKIPPED_BODY_H
+
+#include <wrparse/SPPF.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/TokenRun.h>
+
+
+namespace wr {
+namespace parse {
+
+
+class CXXParser;
+class SymbolTable;
+
+
+/**
+ * \brief Tokens of a function body passed over in
+ *      \c cxx::SKIP_FUNCTION_BODIES mode
+ *
+ * The parser collapses each skipped compound-statement into a single
+ * \c TOK_SKIPPED_BODY token and keeps its tokens here, retrievable through
+ * CXXParser::skippedBody(). The body may be parsed later by parse(), given
+ * the symbols of the parser that skipped it so that the names in scope at
+ * the body, such as the members of an enclosing class, are known.
+ */
+class WRPARSECXX_API SkippedBody :
+        public TokenRun
+{
+public:
+        using this_t = SkippedBody;
+        using base_t = TokenRun;
+
+        SPPFNode::Ptr parse(CXXParser &parser, const SymbolTable &scope);
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_SKIPPED_BODY_H
@@ -0,0 +1,145 @@
+/**
+ * \file SymbolTable.h
+ *
+ * \brief Scoped table of names declared during parsing
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_SYMBOL_TABLE_H
+#define WRPARSECXX_SYMBOL_TABLE_H
+
+#include <stdint.h>
+#include <forward_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wrutil/CityHash.h>
+#include <wrutil/u8string_view.h>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Names declared so far in the parser's input
+ *
+ * Symbols are identified by name and by the source offset of the token
+ * declaring them. Scopes are not entered and left explicitly as the GLL
+ * parser may complete nonterminals in any order; instead a symbol is visible
+ * from just after its declaring token until the end of the scope it was
+ * declared in, which is set by closeScope() once the enclosing class body,
+ * block or template declaration has been parsed. Lookups are made at a
+ * source offset and return the most recently declared symbol visible there.
+ */
+class WRPARSECXX_API SymbolTable
+{
+public:
+        using this_t = SymbolTable;
+
+        SymbolTable() = default;
+        SymbolTable(const this_t &) = delete;  // open_ refers into table_
+
+        this_t &operator=(const this_t &) = delete;
+
+        /**
+         * \brief Kinds of declared name; may be combined where a name was
+         *      parsed in more than one way or is a template
+         */
+        enum Kind : uint8_t
+        {
+                OBJECT             = 0x01,  /**< variable, function or
+                                                 enumerator */
+                TYPEDEF            = 0x02,  /**< typedef-name, alias or
+                                                 template type parameter */
+                CLASS              = 0x04,  ///< class, struct or union
+                ENUM               = 0x08,  ///< enumeration
+                NAMESPACE          = 0x10,  ///< original namespace name
+                NAMESPACE_ALIAS    = 0x20,  ///< namespace alias
+                TEMPLATE           = 0x40,  ///< template-name
+                TEMPLATE_PARAMETER = 0x80,  ///< declared by template header
+
+                ANY                = 0xff
+        };
+
+        struct Symbol
+        {
+                u8string_view name;
+                uint8_t       kind;
+                size_t        offset;     ///< offset of declaring token
+                size_t        scope_end;  /**< offset of end of enclosing
+                                               scope, \c SIZE_MAX if open */
+        };
+
+        this_t &declare(const u8string_view &name, uint8_t kind,
+                        size_t offset);
+
+        this_t &closeScope(size_t begin, size_t end, uint8_t kinds = ANY);
+
+        this_t &withdraw(size_t offset);
+
+        const Symbol *lookup(const u8string_view &name, size_t offset,
+                             uint8_t kinds = ANY) const;
+
+        bool inTemplate(size_t offset) const;
+
+        this_t &setParent(const SymbolTable *parent)
+                { parent_ = parent; return *this; }
+        const SymbolTable *parent() const { return parent_; }
+
+        size_t size() const { return count_; }
+
+        this_t &clear();
+
+private:
+        struct OpenSymbol
+        {
+                size_t               offset;
+                std::vector<Symbol> *entries;
+                size_t               index;
+        };
+
+        using Table = std::unordered_map<u8string_view, std::vector<Symbol>,
+                                         CityHash>;
+
+        std::forward_list<std::string> names_;  ///< storage for table keys
+        Table                          table_;
+        std::vector<OpenSymbol>        open_;   /**< symbols whose scope has
+                                                     not been closed, in
+                                                     order of offset */
+        std::vector<OpenSymbol>        declared_;
+                                                /**< every symbol, in order
+                                                     of declaration */
+        std::vector<size_t>            open_templ_parms_;
+                                                /**< offsets of open template
+                                                     parameters, ascending */
+        size_t                         count_  = 0;
+        const SymbolTable             *parent_ = nullptr;
+                                                /**< consulted by lookup() as
+                                                     well as \c *this */
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_SYMBOL_TABLE_H
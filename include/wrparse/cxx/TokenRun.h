@@ -0,0 +1,96 @@
+/**
+ * \file TokenRun.h
+ *
+ * \brief Replayable run of tokens
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_TOKEN_RUN_H
+#define WRPARSECXX_TOKEN_RUN_H
+
+#include <forward_list>
+#include <string>
+#include <vector>
+#include <wrutil/u8string_view.h>
+#include <wrparse/Lexer.h>
+#include <wrparse/Token.h>
+#include <wrparse/cxx/Config.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Self-contained copy of a sequence of tokens, replayable as a lexer
+ *
+ * Token spellings are copied, so a run remains valid after the lexer that
+ * produced its tokens has cleared its storage. As a \c Lexer, a run may be
+ * handed to a parser, which then sees its tokens followed by \c TOK_EOF.
+ */
+class WRPARSECXX_API TokenRun :
+        public Lexer
+{
+public:
+        using this_t = TokenRun;
+        using base_t = Lexer;
+
+        TokenRun();
+        TokenRun(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        virtual Token &lex(Token &token) override;
+
+        this_t &add(const Token &token);
+        this_t &rewind() { pos_ = 0; return *this; }
+
+        size_t size() const { return tokens_.size(); }
+        bool empty() const  { return tokens_.empty(); }
+        size_t beginOffset() const;
+        size_t endOffset() const;
+        size_t pastEndOffset() const;
+
+        bool sameTokens(const this_t &other, ptrdiff_t delta = 0) const;
+        this_t &relocate(const this_t &other);
+        Token &relocate(Token &token, const this_t &other) const;
+
+private:
+        struct Record
+        {
+                TokenKind     kind;
+                TokenFlags    flags;
+                u8string_view spelling;
+                size_t        offset,
+                              line,
+                              column;
+        };
+
+        std::vector<Record>            tokens_;
+        std::forward_list<std::string> spellings_;  ///< storage for tokens_
+        size_t                         pos_ = 0;    ///< next token to replay
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_TOKEN_RUN_H
@@ -0,0 +1,169 @@
+/**
+ * \file TypeTable.h
+ *
+ * \brief Interned representation of declared types
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#ifndef WRPARSECXX_TYPE_TABLE_H
+#define WRPARSECXX_TYPE_TABLE_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <wrutil/u8string_view.h>
+#include <wrparse/SPPF.h>
+#include <wrparse/cxx/Config.h>
+#include <wrparse/cxx/CXXParser.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief Hash-consed graph of the types named by declarations
+ *
+ * Types are built from the \c DeclSpecifier data of a
+ * \c decl_specifier_seq (or similar type specifier sequence) and the
+ * structure of a declarator, and interned: each distinct type is held once
+ * by the table, so two types obtained from the same table are the same if
+ * and only if their pointers are equal.
+ *
+ * Fundamental types are canonicalized (<code>signed int</code>,
+ * \c int and \c signed are all \c int), as are the parameter types of
+ * functions, which are adjusted as the language requires (arrays and
+ * functions become pointers, top-level qualifiers are dropped, a lone
+ * \c void parameter means none). Any other type specifier, such as a class,
+ * enumeration or typedef name or a \c decltype, is represented by its
+ * spelling, without class-key; typedefs are not resolved, nor are names
+ * qualified with their enclosing scopes. An array bound that cannot be
+ * folded to an integer by ConstExprEvaluator is likewise represented by its
+ * spelling.
+ */
+class WRPARSECXX_API TypeTable
+{
+public:
+        using this_t  = TypeTable;
+        using Sign    = CXXParser::DeclSpecifier::Sign;
+        using Size    = CXXParser::DeclSpecifier::Size;
+        using Builtin = CXXParser::DeclSpecifier::Type;
+
+        static const uint64_t UNKNOWN_BOUND = UINT64_MAX;
+
+        struct Type
+        {
+                enum Kind : uint8_t
+                {
+                        BUILTIN,           ///< fundamental type
+                        NAMED,             ///< any other type specifier
+                        POINTER,
+                        MEMBER_POINTER,
+                        LVALUE_REFERENCE,
+                        RVALUE_REFERENCE,
+                        ARRAY,
+                        FUNCTION
+                };
+
+                Kind                      kind;
+                uint8_t                   qualifiers = 0;
+                                        /**< \c CXXParser::CONST etc.; for a
+                                             \c FUNCTION, also its
+                                             ref-qualifier */
+                Sign                      sign       = Sign::NO_SIGN;
+                Size                      size       = Size::NO_SIZE;
+                Builtin                   builtin    = Builtin::NO_TYPE;
+                const Type               *target     = nullptr;
+                                        /**< type pointed or referred to,
+                                             element or return type */
+                u8string_view             name;
+                                        /**< \c NAMED: type's spelling;
+                                             \c MEMBER_POINTER: class;
+                                             \c ARRAY: bound, if not a
+                                             constant */
+                uint64_t                  bound      = UNKNOWN_BOUND;
+                std::vector<const Type *> parameters;
+                bool                      variadic   = false;
+
+                bool operator==(const Type &other) const;
+        };
+
+        TypeTable() = default;
+        TypeTable(const this_t &) = delete;
+
+        this_t &operator=(const this_t &) = delete;
+
+        const Type *forSpecifiers(CXXParser &cxx,
+                                  const SPPFNode &decl_specifier_seq);
+        const Type *forDeclarator(CXXParser &cxx,
+                                  const SPPFNode &decl_specifier_seq,
+                                  const SPPFNode *declarator);
+        const Type *forTypeId(CXXParser &cxx, const SPPFNode &type_id);
+
+        const Type *builtin(Sign sign, Size size, Builtin builtin,
+                            uint8_t qualifiers = 0);
+        const Type *named(const u8string_view &name, uint8_t qualifiers = 0);
+        const Type *pointer(const Type *pointee, uint8_t qualifiers = 0);
+        const Type *memberPointer(const u8string_view &class_name,
+                                  const Type *pointee,
+                                  uint8_t qualifiers = 0);
+        const Type *reference(const Type *referee, bool rvalue = false);
+        const Type *array(const Type *element, uint64_t bound,
+                          const u8string_view &bound_expr = {});
+        const Type *function(const Type *result,
+                             std::vector<const Type *> parameters,
+                             bool variadic = false, uint8_t qualifiers = 0);
+
+        const Type *qualified(const Type *type, uint8_t qualifiers);
+        const Type *unqualified(const Type *type);
+
+        size_t size() const { return types_.size(); }
+        this_t &clear();
+
+private:
+        struct TypeHash
+        {
+                size_t operator()(const Type &type) const;
+        };
+
+        const Type *intern(Type &&type);
+        u8string_view internName(const u8string_view &name);
+
+        const Type *applyDeclarator(CXXParser &cxx, const Type *type,
+                                    const SPPFNode &declarator);
+        const Type *functionOf(CXXParser &cxx, const Type *result,
+                               const SPPFNode &parameters_and_qualifiers);
+        const Type *arrayOf(CXXParser &cxx, const Type *element,
+                            const SPPFNode &array_declarator);
+        const Type *parameterType(CXXParser &cxx,
+                                  const SPPFNode &parameter_declaration,
+                                  bool &is_void);
+
+        std::unordered_set<Type, TypeHash> types_;
+        std::unordered_set<std::string>    names_;  ///< storage for names
+};
+
+
+} // namespace parse
+} // namespace wr
+
+
+#endif // !WRPARSECXX_TYPE_TABLE_H
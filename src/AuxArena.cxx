@@ -0,0 +1,232 @@
+/**
+ * \file AuxArena.cxx
+ *
+ * \brief Per-parser arena for auxiliary data
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <wrparse/cxx/AuxArena.h>
+
+
+namespace wr {
+namespace parse {
+
+
+struct AuxArena::Pool
+{
+        struct Chunk
+        {
+                Pool                    *pool;
+                std::unique_ptr<char[]>  data;
+                size_t                   bytes,
+                                         used = 0,  ///< bytes handed out
+                                         live = 0;  ///< objects alive
+        };
+
+        using ChunkPtr = std::unique_ptr<Chunk>;
+
+        std::vector<ChunkPtr> chunks;
+        std::vector<Chunk *>  spare;               ///< empty, not in use
+        Chunk                *current  = nullptr;  ///< chunk in use
+        size_t                chunk_bytes,
+                              live     = 0;        ///< objects alive
+        bool                  orphaned = false;    ///< arena destroyed
+
+        Chunk *newChunk(size_t bytes);
+};
+
+/*
+ * Precedes every object, recording the chunk to return it to; padded so
+ * that objects are suitably aligned for any type
+ */
+struct alignas(std::max_align_t) AuxArena::Header
+{
+        Pool::Chunk *chunk;
+};
+
+//--------------------------------------
+
+AuxArena::Pool::Chunk *
+AuxArena::Pool::newChunk(
+        size_t bytes
+)
+{
+        chunks.emplace_back(new Chunk { this,
+                                        std::unique_ptr<char[]>(
+                                                new char[bytes]),
+                                        bytes });
+        return chunks.back().get();
+}
+
+//--------------------------------------
+
+WRPARSECXX_API
+AuxArena::AuxArena(
+        size_t chunk_bytes  ///< size of each chunk requested from the heap
+) :
+        pool_(new Pool)
+{
+        pool_->chunk_bytes = chunk_bytes;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API
+AuxArena::~AuxArena()
+{
+        if (pool_->live) {
+                pool_->orphaned = true;  // freed with the last object
+        } else {
+                delete pool_;
+        }
+}
+
+//--------------------------------------
+/**
+ * \brief allocate space for an object
+ *
+ * \param [in] bytes
+ *      size of object
+ * \return
+ *      suitably-aligned space for the object, to be passed to deallocate()
+ *      once the object is destroyed
+ */
+WRPARSECXX_API void *
+AuxArena::allocate(
+        size_t bytes
+)
+{
+        static const size_t ALIGN = alignof(Header);
+
+        Pool &pool = *pool_;
+
+        bytes = sizeof(Header) + (bytes + ALIGN - 1) / ALIGN * ALIGN;
+
+        if (!pool.current
+                        || (pool.current->used + bytes > pool.current->bytes)) {
+                if (!pool.spare.empty()
+                                && (bytes <= pool.spare.back()->bytes)) {
+                        pool.current = pool.spare.back();
+                        pool.spare.pop_back();
+                } else {
+                        pool.current = pool.newChunk(
+                                std::max(bytes, pool.chunk_bytes));
+                }
+        }
+
+        Pool::Chunk &chunk  = *pool.current;
+        auto         header = new (chunk.data.get() + chunk.used) Header;
+
+        header->chunk = &chunk;
+        chunk.used += bytes;
+        ++chunk.live;
+        ++pool.live;
+        return header + 1;
+}
+
+//--------------------------------------
+/**
+ * \brief return the space of a destroyed object to its arena
+ *
+ * The space is not reused until every object in the same chunk has been
+ * destroyed.
+ */
+WRPARSECXX_API void
+AuxArena::deallocate(
+        void *object
+) // static
+{
+        if (!object) {
+                return;
+        }
+
+        Pool::Chunk &chunk = *(static_cast<Header *>(object) - 1)->chunk;
+        Pool        *pool  = chunk.pool;
+
+        --pool->live;
+        if (--chunk.live) {
+                return;
+        } else if (pool->orphaned) {
+                if (!pool->live) {
+                        delete pool;
+                }
+                return;
+        }
+
+        chunk.used = 0;
+        if (&chunk != pool->current) {
+                pool->spare.push_back(&chunk);
+        }
+}
+
+//--------------------------------------
+/**
+ * \brief return every chunk holding no objects to the heap, except the
+ *      one in use
+ *
+ * Chunks holding objects that are still alive are kept.
+ */
+WRPARSECXX_API AuxArena &
+AuxArena::release()
+{
+        Pool &pool = *pool_;
+
+        pool.chunks.erase(
+                std::remove_if(pool.chunks.begin(), pool.chunks.end(),
+                               [&pool](const Pool::ChunkPtr &c) {
+                                       return !c->live
+                                              && (c.get() != pool.current);
+                               }),
+                pool.chunks.end());
+        pool.spare.clear();
+
+        return *this;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+AuxArena::live() const
+{
+        return pool_->live;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+AuxArena::capacity() const
+{
+        size_t bytes = 0;
+
+        for (const auto &chunk: pool_->chunks) {
+                bytes += chunk->bytes;
+        }
+
+        return bytes;
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -35,6 +35,7 @@
 #include <wrutil/utf8.h>
 #include <wrparse/cxx/CXXLexer.h>
 #include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/PrecompiledTokens.h>
 
 
 namespace wr {
@@ -75,6 +76,11 @@ CXXLexer::lex(
 {
         bool again;
 
+        if (prefix_ && (prefix_pos_ < prefix_->size())) {
+                base_t::lex(t);  // initialise token
+                return prefix_->get(prefix_pos_++, t);
+        }
+
         do {
                 again = false;
                 base_t::lex(t);  // initialise token
@@ -91,6 +97,10 @@ CXXLexer::lex(
                 }
         } while (again);
 
+        if (prefix_) {  // continue on from end of prefix header
+                t.adjustOffset(static_cast<ptrdiff_t>(prefix_->sourceBytes()));
+        }
+
         return t;
 }
 
@@ -871,10 +881,56 @@ WRPARSECXX_API CXXLexer &
 CXXLexer::clearStorage()
 {
         kw_id_table_ = options_.keywords();
+        addPrefixIdentifiers();
         base_t::clearStorage();
         return *this;
 }
 
+//--------------------------------------
+/**
+ * \brief replay a precompiled prefix header ahead of the lexer's input
+ *
+ * The tokens held by \c prefix are returned by lex() before any token is
+ * read from the input stream, as if the prefix header's text preceded the
+ * input; offsets of tokens read from the input are adjusted accordingly.
+ * Identifiers from the prefix are entered in the lexer's identifier table so
+ * that later occurrences in the input share the image's spellings.
+ *
+ * \param [in] prefix
+ *      token image loaded with options identical to this lexer's; must
+ *      outlive the lexer
+ * \throw std::invalid_argument
+ *      if \c prefix was built with different language options
+ */
+WRPARSECXX_API CXXLexer &
+CXXLexer::setPrefixTokens(
+        const PrecompiledTokens &prefix
+)
+{
+        if (!prefix.compatibleWith(options_)) {
+                throw std::invalid_argument(
+                        "precompiled tokens built for different language options");
+        }
+
+        prefix_ = &prefix;
+        prefix_pos_ = 0;
+        addPrefixIdentifiers();
+        return *this;
+}
+
+//--------------------------------------
+
+void
+CXXLexer::addPrefixIdentifiers()
+{
+        if (prefix_) {
+                for (size_t i = 0, n = prefix_->identifierCount(); i < n; ++i) {
+                        kw_id_table_.insert({ prefix_->identifier(i),
+                                              TOK_IDENTIFIER });
+                }
+        }
+}
+
 //--------------------------------------
 
 char32_t
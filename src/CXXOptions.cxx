@@ -113,6 +113,21 @@ CXXOptions::CXXOptions(
         if (extra_features & cxx::NO_PP_DIRECTIVES) {
                 features_ |= cxx::NO_PP_DIRECTIVES;
         }
+        if (extra_features & cxx::LONE_OPERAND_FAST_PATH) {
+                features_ |= cxx::LONE_OPERAND_FAST_PATH;
+        }
+        if (extra_features & cxx::SKIP_FUNCTION_BODIES) {
+                features_ |= cxx::SKIP_FUNCTION_BODIES;
+        }
+        if (extra_features & cxx::FIRST_SET_LOOKAHEAD) {
+                features_ |= cxx::FIRST_SET_LOOKAHEAD;
+        }
+        if (extra_features & cxx::DEFERRED_ACTIONS) {
+                features_ |= cxx::DEFERRED_ACTIONS;
+        }
+        if (extra_features & cxx::LITERAL_LISTS) {
+                features_ |= cxx::LITERAL_LISTS;
+        }
 }
 
 //--------------------------------------
@@ -22,9 +22,16 @@
  *
  * \endparblock
  */
+#include <assert.h>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
 #include <wrutil/numeric_cast.h>
 #include <wrparse/cxx/CXXLexer.h>
 #include <wrparse/cxx/CXXParser.h>
+#include <wrparse/cxx/LiteralList.h>
+#include <wrparse/cxx/ParseMemo.h>
+#include <wrparse/cxx/ParseProfile.h>
 #include <wrparse/cxx/CXXTokenKinds.h>
 
 
@@ -36,10 +43,12 @@ using namespace cxx;
 
 
 WRPARSECXX_API
-CXXParser::CXXParser(
-        const CXXOptions &options
+CXXParser::Grammar::Grammar(
+        const CXXOptions &options,
+        uint8_t           hooks
 ) :
         options_(options),
+        hooks_  (hooks),
 
         /*
          * A.1 Keywords [gram.key]
@@ -491,7 +500,15 @@ CXXParser::CXXParser(
         }, NonTerminal::HIDE_IF_DELEGATE },
 
         assignment_expression { "assignment-expression", {
-                { conditional_expression },
+                {{ conditional_expression },
+                        !options.have(cxx::LONE_OPERAND_FAST_PATH) },
+                {{ pred(conditional_expression, &isCompoundOperand) },
+                        options.have(cxx::LONE_OPERAND_FAST_PATH) },
+                {{ pred(primary_expression, &isSimpleOperand) },
+                        options.have(cxx::LONE_OPERAND_FAST_PATH) },
+                                        /* shortcut for lone identifier or
+                                           literal; same SPPF shape as the
+                                           delegating levels are hidden */
                 {{ logical_or_expression, assignment_operator,
                         initializer_clause }, langCXX() },
                 {{ throw_expression }, langCXX() },
@@ -519,7 +536,12 @@ CXXParser::CXXParser(
         }},
 
         constant_expression { "constant-expression", {
-                { conditional_expression }
+                {{ conditional_expression },
+                        !options.have(cxx::LONE_OPERAND_FAST_PATH) },
+                {{ pred(conditional_expression, &isCompoundOperand) },
+                        options.have(cxx::LONE_OPERAND_FAST_PATH) },
+                {{ pred(primary_expression, &isSimpleOperand) },
+                        options.have(cxx::LONE_OPERAND_FAST_PATH) }
         }},
 
         /*--------------------------------------
@@ -981,10 +1003,12 @@ CXXParser::CXXParser(
         }},
 
         attribute_argument_clause { "attribute_argument_clause", stdCXX11(), {
-                { TOK_LPAREN, balanced_token_seq, TOK_RPAREN }
+                { pred(TOK_LPAREN, &collapseBalancedTokens),
+                        balanced_token_seq, TOK_RPAREN }
         }},
 
         balanced_token_seq { "balanced-token-seq", stdCXX11(), {
+                { TOK_BALANCED_TOKEN_SEQ },  // see collapseBalancedTokens()
                 { opt(balanced_token) },
                 { balanced_token_seq, balanced_token }
         }, NonTerminal::TRANSPARENT },
@@ -1172,13 +1196,31 @@ CXXParser::CXXParser(
                    making decl-specifier-seq mandatory in the first rule
                    (reason: the declarator-id's of constructor declarations
                    are mistaken for a decl-specifier-seq) */
-                { opt(attribute_specifier_seq), decl_specifier_seq,
+                {{ opt(attribute_specifier_seq), decl_specifier_seq,
                         declarator, opt(virt_specifier_seq), function_body },
-                { opt(attribute_specifier_seq), declarator,
-                        opt(virt_specifier_seq), function_body }
+                        !options.have(cxx::SKIP_FUNCTION_BODIES) },
+                {{ opt(attribute_specifier_seq), declarator,
+                        opt(virt_specifier_seq), function_body },
+                        !options.have(cxx::SKIP_FUNCTION_BODIES) },
+
+                /* when skipping bodies, make sure a braced initializer
+                   following an object declarator is never taken for one;
+                   checked on the body, by which point the declarator has
+                   been parsed */
+                {{ opt(attribute_specifier_seq), decl_specifier_seq,
+                        declarator, opt(virt_specifier_seq),
+                        pred(function_body, &Declarator::isFunction) },
+                        options.have(cxx::SKIP_FUNCTION_BODIES) },
+                {{ opt(attribute_specifier_seq), declarator,
+                        opt(virt_specifier_seq),
+                        pred(function_body, &Declarator::isFunction) },
+                        options.have(cxx::SKIP_FUNCTION_BODIES) }
         }},
 
         function_body { "function-body", {
+                {{ opt(ctor_initializer),
+                        pred(TOK_SKIPPED_BODY, &skipFunctionBody) },
+                        options.have(cxx::SKIP_FUNCTION_BODIES) },
                 { opt(ctor_initializer), compound_statement },
                 {{ function_try_block }, langCXX() },
 
@@ -1211,6 +1253,8 @@ CXXParser::CXXParser(
         }},
 
         braced_init_list { "braced-init-list", {
+                {{ pred(TOK_LBRACE, &collapseLiteralList), TOK_LITERAL_LIST,
+                        TOK_RBRACE }, options.have(cxx::LITERAL_LISTS) },
                 { TOK_LBRACE, initializer_list, opt(TOK_COMMA), TOK_RBRACE },
                 { TOK_LBRACE, TOK_RBRACE }
         }},
@@ -1248,8 +1292,13 @@ CXXParser::CXXParser(
 
         class_head_name { "class-head-name", {
                 { opt(nested_name_specifier), class_name },
-                { opt(nested_name_specifier), undeclared_name },
-                { opt(nested_name_specifier), simple_template_id }
+                /* deviation from original C++11 grammar: any name not already
+                   declared as a class, including one hidden by or shared with
+                   a non-class name (e.g. "struct stat" vs. "stat()") */
+                { opt(nested_name_specifier),
+                        pred(identifier, &isClassHeadName) },
+                {{ opt(nested_name_specifier), simple_template_id },
+                        langCXX() }
         }},
 
         class_virt_specifier { "class-virt-specifier", stdCXX11(), {
@@ -1576,19 +1625,352 @@ CXXParser::CXXParser(
         type_specifier_seq.addPostParseAction(&DeclSpecifier::end);
         trailing_type_specifier_seq.addPostParseAction(&DeclSpecifier::end);
 
-        declarator.addPostParseAction(&Declarator::end);
-        nested_declarator.addPostParseAction(&Declarator::end);
-        abstract_declarator.addPostParseAction(&Declarator::end);
-        nested_abstract_declarator.addPostParseAction(&Declarator::end);
-        new_declarator.addPostParseAction(&Declarator::end);
-        conversion_declarator.addPostParseAction(&Declarator::end);
+        if (!options.have(cxx::DEFERRED_ACTIONS)) {
+                declarator.addPostParseAction(&Declarator::end);
+                nested_declarator.addPostParseAction(&Declarator::end);
+                abstract_declarator.addPostParseAction(&Declarator::end);
+                nested_abstract_declarator.addPostParseAction(
+                                                        &Declarator::end);
+                new_declarator.addPostParseAction(&Declarator::end);
+                conversion_declarator.addPostParseAction(&Declarator::end);
+
+                lambda_declarator.addPostParseAction(
+                                &DeclaratorPart::endParametersAndQualifiers);
+                parameters_and_qualifiers.addPostParseAction(
+                                &DeclaratorPart::endParametersAndQualifiers);
+
+                ptr_operator.addPostParseAction(
+                                &DeclaratorPart::endPtrOperator);
+        }  // else see runDeferredActions()
+
+        simple_declaration.addPostParseAction(&declareNames);
+        member_declaration.addPostParseAction(&declareNames);
+        function_definition.addPostParseAction(&declareNames);
+
+        class_head.addPostParseAction(&declareName);
+        elaborated_type_specifier.addPostParseAction(&declareName);
+        enum_head.addPostParseAction(&declareName);
+        opaque_enum_declaration.addPostParseAction(&declareName);
+        enumerator.addPostParseAction(&declareName);
+        original_namespace_definition.addPostParseAction(&declareName);
+        namespace_alias_definition.addPostParseAction(&declareName);
+        alias_declaration.addPostParseAction(&declareName);
+        using_declaration.addPostParseAction(&declareName);
+
+        template_parameter.addPostParseAction(&declareTemplateParameter);
+
+        class_specifier.addPostParseAction(&endScope);
+        enum_specifier.addPostParseAction(&endScope);
+        compound_statement.addPostParseAction(&endScope);
+        template_declaration.addPostParseAction(&endScope);
+
+        primary_expression.addPostParseAction(&checkPrimaryExpression);
+
+        prune();
+        computeFirstSets();
+
+        for (const NonTerminal *nt: nonterminals_) {
+                const FirstSet &nt_first = nonterminal_first_[nt];
+
+                if (options.have(cxx::FIRST_SET_LOOKAHEAD)
+                                && !nt_first.nullable
+                                && !nt_first.tokens.all()) {
+                        nt->addPreParseAction(&checkFirstSet);
+                }
+                if (hooks & PROFILING) {
+                        nt->addPreParseAction(&profileEnter);
+                        nt->addPostParseAction(&profileLeave);
+                }
+                if (hooks & FILTERING) {
+                        nt->addPostParseAction(&applyFilters);
+                }
+        }
+}
+
+//--------------------------------------
+
+/*
+ * Find the nonterminals and rules that can take part in a parse with the
+ * grammar's options: enabled nonterminals that can derive some token
+ * sequence through enabled rules ("productive"), and are reachable from
+ * translation_unit through such rules. A rule needing a dead nonterminal
+ * other than as an optional component is dead too, though enabled; such
+ * rules cost the parser a visit for nothing, so the grammar above guards
+ * them with the options they need and deadRules() is normally zero.
+ */
+void
+CXXParser::Grammar::prune()
+{
+        std::unordered_set<const NonTerminal *> productive, reachable;
+        bool                                    changed;
+
+        auto usable = [&](const Rule &rule) {
+                if (!rule.enabled()) {
+                        return false;
+                }
+                for (const Component &comp: rule) {
+                        if (comp.isNonTerminal() && !comp.isOptional()
+                                        && !productive.count(
+                                                        comp.nonTerminal())) {
+                                return false;
+                        }
+                }
+                return true;
+        };
+
+        std::vector<const NonTerminal *> all;
+
+        all.push_back(&translation_unit);
+        reachable.insert(&translation_unit);
+
+        for (size_t i = 0; i < all.size(); ++i) {  // everything referenced
+                for (const Rule &rule: *all[i]) {
+                        for (const Component &comp: rule) {
+                                if (comp.isNonTerminal()
+                                        && reachable.insert(comp.nonTerminal())
+                                               .second) {
+                                        all.push_back(comp.nonTerminal());
+                                }
+                        }
+                }
+        }
+
+        do {
+                changed = false;
+                for (const NonTerminal *nt: all) {
+                        if (!nt->enabled() || productive.count(nt)) {
+                                continue;
+                        }
+                        for (const Rule &rule: *nt) {
+                                if (usable(rule)) {
+                                        productive.insert(nt);
+                                        changed = true;
+                                        break;
+                                }
+                        }
+                }
+        } while (changed);
+
+        reachable.clear();
+        nonterminals_.clear();
+        dead_rules_ = 0;
+
+        if (!productive.count(&translation_unit)) {
+                return;
+        }
+
+        nonterminals_.push_back(&translation_unit);
+        reachable.insert(&translation_unit);
+
+        for (size_t i = 0; i < nonterminals_.size(); ++i) {
+                for (const Rule &rule: *nonterminals_[i]) {
+                        if (!usable(rule)) {
+                                dead_rules_ += rule.enabled();
+                                continue;
+                        }
+                        for (const Component &comp: rule) {
+                                const NonTerminal *nt = comp.nonTerminal();
+                                if (comp.isNonTerminal() && productive.count(nt)
+                                                && reachable.insert(nt).second) {
+                                        nonterminals_.push_back(nt);
+                                }
+                        }
+                }
+        }
+}
+
+//--------------------------------------
+
+/*
+ * Compute the FIRST set of every live nonterminal and usable rule by
+ * iterating to a fixed point. A terminal carrying a predicate may have its
+ * token rewritten by the predicate before it is matched (see
+ * processTemplParmArgListEndToken(), skipFunctionBody(),
+ * collapseBalancedTokens() and collapseLiteralList()), so such a terminal
+ * is taken to admit any token.
+ */
+void
+CXXParser::Grammar::computeFirstSets()
+{
+        nonterminal_first_.clear();
+        rule_first_.clear();
+
+        for (const NonTerminal *nt: nonterminals_) {
+                nonterminal_first_[nt];
+        }
+
+        auto rule_first = [&](const Rule &rule, FirstSet &result) {
+                result.nullable = true;
+
+                for (const Component &comp: rule) {
+                        bool nullable = comp.isOptional();
+
+                        if (comp.isTerminal()) {
+                                if (comp.predicate()
+                                    || (comp.terminal() >= cxx::TOK_CXX_END)) {
+                                        result.tokens.set();
+                                } else {
+                                        result.tokens.set(comp.terminal());
+                                }
+                        } else if (comp.isNonTerminal()) {
+                                auto i = nonterminal_first_.find(
+                                                        comp.nonTerminal());
+                                if (i == nonterminal_first_.end()) {
+                                        return false;  // rule is dead
+                                }
+                                result.tokens |= i->second.tokens;
+                                nullable |= i->second.nullable;
+                        } else {
+                                nullable = true;  // predicate alone
+                        }
+
+                        if (!nullable) {
+                                result.nullable = false;
+                                break;
+                        }
+                }
+
+                return true;
+        };
+
+        bool changed;
+
+        do {
+                changed = false;
+                for (const NonTerminal *nt: nonterminals_) {
+                        FirstSet &nt_first = nonterminal_first_[nt];
+
+                        for (const Rule &rule: *nt) {
+                                FirstSet computed;
+
+                                if (!rule.enabled()
+                                    || !rule_first(rule, computed)) {
+                                        continue;
+                                }
+
+                                FirstSet &known = rule_first_[&rule];
+
+                                if ((computed.tokens != known.tokens)
+                                    || (computed.nullable != known.nullable)) {
+                                        known = computed;
+                                        changed = true;
+                                }
+
+                                if ((nt_first.tokens | computed.tokens)
+                                                        != nt_first.tokens) {
+                                        nt_first.tokens |= computed.tokens;
+                                        changed = true;
+                                }
+                                if (computed.nullable && !nt_first.nullable) {
+                                        nt_first.nullable = true;
+                                        changed = true;
+                                }
+                        }
+                }
+        } while (changed);
+}
+
+//--------------------------------------
+/**
+ * \brief retrieve the shared grammar for a configuration
+ *
+ * Grammars are built on first request and then kept for the lifetime of
+ * the program; concurrent calls are safe.
+ *
+ * \param [in] options
+ *      language options; only the languages and features are significant
+ * \param [in] hooks
+ *      combination of \c Hooks values
+ */
+WRPARSECXX_API CXXParser::Grammar::Ptr
+CXXParser::Grammar::get(
+        const CXXOptions &options,
+        uint8_t           hooks
+) // static
+{
+        static std::mutex       lock;
+        static std::vector<Ptr> grammars;
+
+        std::lock_guard<std::mutex> guard(lock);
+
+        for (const Ptr &grammar: grammars) {
+                if ((grammar->hooks_ == hooks)
+                    && (grammar->options_.languages() == options.languages())
+                    && (grammar->options_.features() == options.features())) {
+                        return grammar;
+                }
+        }
+
+        grammars.emplace_back(new Grammar(options, hooks));
+        return grammars.back();
+}
+
+//--------------------------------------
+/**
+ * \brief find a live nonterminal by name, e.g. \c "declaration"
+ *
+ * \return
+ *      the nonterminal, or \c nullptr if there is no such nonterminal or it
+ *      cannot take part in a parse with the grammar's options
+ */
+WRPARSECXX_API const NonTerminal *
+CXXParser::Grammar::find(
+        const char *name
+) const
+{
+        for (const NonTerminal *nt: nonterminals_) {
+                if (u8string_view(nt->name()) == name) {
+                        return nt;
+                }
+        }
+
+        return nullptr;
+}
+
+//--------------------------------------
+/**
+ * \brief retrieve the token kinds that can begin a live nonterminal
+ *
+ * \return
+ *      the nonterminal's FIRST set, or \c nullptr if it cannot take part in
+ *      a parse with the grammar's options
+ */
+WRPARSECXX_API const CXXParser::Grammar::FirstSet *
+CXXParser::Grammar::first(
+        const NonTerminal &nonterminal
+) const
+{
+        auto i = nonterminal_first_.find(&nonterminal);
+        return (i != nonterminal_first_.end()) ? &i->second : nullptr;
+}
+
+//--------------------------------------
+/**
+ * \brief retrieve the token kinds that can begin one rule of a live
+ *      nonterminal
+ *
+ * \return
+ *      the rule's FIRST set, or \c nullptr if the rule is disabled or needs
+ *      a nonterminal that cannot take part in a parse
+ */
+WRPARSECXX_API const CXXParser::Grammar::FirstSet *
+CXXParser::Grammar::first(
+        const Rule &rule
+) const
+{
+        auto i = rule_first_.find(&rule);
+        return (i != rule_first_.end()) ? &i->second : nullptr;
+}
 
-        lambda_declarator.addPostParseAction(
-                           &DeclaratorPart::endParametersAndQualifiers);
-        parameters_and_qualifiers.addPostParseAction(
-                           &DeclaratorPart::endParametersAndQualifiers);
+//--------------------------------------
 
-        ptr_operator.addPostParseAction(&DeclaratorPart::endPtrOperator);
+WRPARSECXX_API
+CXXParser::CXXParser(
+        const CXXOptions &options
+) :
+        options_(options),
+        grammar_(Grammar::get(options))
+{
 }
 
 //--------------------------------------
@@ -1619,304 +2001,408 @@ CXXParser::CXXParser(
 WRPARSECXX_API CXXParser::~CXXParser() = default;
 
 //--------------------------------------
-
-template <> WRPARSECXX_API CXXParser::DeclSpecifier *
-CXXParser::get(
-        const SPPFNode &decl_spec_seq
-)
+/**
+ * \brief discard the parser's state and any partial parse
+ *
+ * Also returns the memory of DeclSpecifier, Declarator and DeclaratorPart
+ * data to the heap in bulk, chunk by chunk, keeping only the chunks holding
+ * data still retained. Names declared in symbols() are kept.
+ */
+WRPARSECXX_API CXXParser &
+CXXParser::reset()
 {
-        return dynamic_cast<DeclSpecifier *>(decl_spec_seq.auxData().get());
+        Parser::reset();
+        aux_arena_.release();
+        return *this;
 }
 
 //--------------------------------------
-
-template <> WRPARSECXX_API CXXParser::Declarator *
-CXXParser::get(
-        const SPPFNode &declarator
+/**
+ * \brief parse a nonterminal from the current input position
+ *
+ * As Parser::parse(), then with \c cxx::DEFERRED_ACTIONS builds the
+ * declarator data of, and diagnoses, the declarators in the result; the
+ * many candidate declarators abandoned along the way are never visited.
+ *
+ * Names are entered in symbols() as each candidate declaration is parsed,
+ * so that later parts of the input can be disambiguated, including those
+ * of candidates the parser goes on to reject. Once a result is found the
+ * names entered since its first token are withdrawn and those declared by
+ * the result alone are entered again, so that no rejected candidate
+ * influences the parse of the declarations that follow.
+ */
+WRPARSECXX_API SPPFNode::Ptr
+CXXParser::parse(
+        const NonTerminal &nonterminal
 )
 {
-        return dynamic_cast<Declarator *>(declarator.auxData().get());
+        SPPFNode::Ptr result = Parser::parse(nonterminal);
+
+        if (profile_) {
+                profile_->finish();
+        }
+
+        if (result && options_.have(cxx::DEFERRED_ACTIONS)) {
+                runDeferredActions(*result);
+        }
+
+        if (result && !result->empty()) {
+                symbols_.withdraw(result->firstToken()->offset());
+                redeclare(*result);
+        }
+
+        return result;
 }
 
 //--------------------------------------
-
-template <> WRPARSECXX_API CXXParser::DeclaratorPart *
-CXXParser::get(
-        const SPPFNode &part
+/**
+ * \brief parse a translation unit one top-level declaration at a time
+ *
+ * Each declaration is handed to \c visit as soon as it has been parsed,
+ * after which its tokens, SPPF nodes and DeclSpecifier, Declarator and
+ * DeclaratorPart data are released, along with any skipped function
+ * bodies and the derivations recorded by the memo (whose statistics are
+ * kept). Memory held is thus bounded by the largest declaration rather
+ * than the size of the input, provided \c visit keeps no reference to the
+ * nodes it is given. Any DeclSpecifier, Declarator or DeclaratorPart data
+ * that \c visit does keep holds its arena chunk, which is then not
+ * released. Only the names entered in symbols() accumulate.
+ *
+ * \param [in] lexer
+ *      lexer reading the translation unit; parsing continues until its
+ *      input stream is exhausted or fails
+ * \param [in] visit
+ *      called with each parsed declaration; returns \c false to stop
+ * \return
+ *      number of declarations in which errors were reported; such
+ *      declarations are still visited if a parse was found
+ */
+WRPARSECXX_API size_t
+CXXParser::parseDeclarations(
+        CXXLexer                 &lexer,
+        const DeclarationVisitor &visit
 )
 {
-        return dynamic_cast<DeclaratorPart *>(part.auxData().get());
+        size_t failed = 0;
+        bool   more   = true;
+
+        setLexer(lexer);
+
+        while (more && lexer.input().good()) {
+                size_t        errors = errorCount();
+                SPPFNode::Ptr result = parse(grammar().declaration);
+
+                if (result) {
+                        more = visit(*result);
+                        result.reset();
+                }
+
+                if (errorCount() != errors) {
+                        ++failed;
+                        reset();
+                }
+
+                skipped_bodies_.clear();
+                literal_lists_.clear();
+                collapsed_.clear();
+                if (memo_) {
+                        memo_->clearDerivations();
+                }
+                aux_arena_.release();
+                lexer.clearStorage();
+        }
+
+        return failed;
 }
 
 //--------------------------------------
 
-uint8_t
-CXXParser::qualifierForToken(
-        const Token &token
+/*
+ * Run the declarator actions not registered with the grammar in
+ * DEFERRED_ACTIONS mode over every node reachable from root, including
+ * all alternatives of ambiguous nodes, in source order
+ */
+void
+CXXParser::runDeferredActions(
+        const SPPFNode &root
 )
 {
-        switch (token.kind()) {
-        case TOK_KW_CONST:
-                return CONST;
-        case TOK_KW_VOLATILE:
-                return VOLATILE;
-        case TOK_KW_RESTRICT:
-                return RESTRICT;
-        case TOK_KW_ATOMIC:
-                return ATOMIC;
-        case TOK_AMP:
-                return LVAL_REF;
-        case TOK_AMPAMP:
-                return RVAL_REF;
-        default:
-                return 0;
+        std::vector<const SPPFNode *>        pending { &root },
+                                             children;
+        std::unordered_set<const SPPFNode *> seen    { &root };
+
+        while (!pending.empty()) {
+                const SPPFNode &node = *pending.back();
+
+                pending.pop_back();
+                children.clear();
+
+                for (const SPPFNode &child: node) {
+                        if (seen.insert(&child).second) {
+                                children.push_back(&child);
+                        }
+                }
+
+                pending.insert(pending.end(), children.rbegin(),
+                               children.rend());
+
+                if (!node.isNonTerminal() || node.auxData()) {
+                        continue;
+                }
+
+                if (auto dcl = Declarator::build(*this, node, true)) {
+                        node.setAuxData(dcl);
+                } else if (auto part = DeclaratorPart::build(*this, node)) {
+                        node.setAuxData(part);
+                }
         }
 }
 
 //--------------------------------------
-
-uint8_t
-CXXParser::typeQualifiersFromSeq(
-        const SPPFNode &type_qualifier_seq
+/**
+ * \brief gather per-nonterminal statistics into \c profile
+ *
+ * The first call switches to a grammar with profiling actions registered
+ * with every live nonterminal; until then profiling costs nothing.
+ * Afterwards passing \c nullptr suspends profiling, leaving only the cost
+ * of the (inactive) actions themselves.
+ * Like addFilter(), this must not be called while parsing.
+ *
+ * \param [in] profile
+ *      profile to accumulate statistics into, or \c nullptr to stop
+ *      profiling; not owned by \c *this and must outlive any parse
+ *      performed while set
+ */
+WRPARSECXX_API CXXParser &
+CXXParser::setProfile(
+        ParseProfile *profile
 )
 {
-        uint8_t qualifiers = 0;
+        profile_ = profile;
 
-        for (const SPPFNode &qualifier: subProductions(type_qualifier_seq)) {
-                qualifiers |= qualifierForToken(*qualifier.firstToken());
+        if (profile && !(grammar_->hooks() & Grammar::PROFILING)) {
+                useGrammar(grammar_->hooks() | Grammar::PROFILING);
         }
 
-        return qualifiers;
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief reuse the judgement of derivations repeated over the same tokens
+ *
+ * While \c memo is set, the actions building DeclSpecifier and Declarator
+ * data consult it before validating a derivation; see ParseMemo.
+ *
+ * \param [in] memo
+ *      memo to record derivations in, or \c nullptr to stop memoizing; not
+ *      owned by \c *this, must outlive any parse performed while set and
+ *      must be cleared before the parser's input changes
+ */
+WRPARSECXX_API CXXParser &
+CXXParser::setMemo(
+        ParseMemo *memo
+)
+{
+        memo_ = memo;
+        return *this;
 }
 
 //--------------------------------------
 
+/*
+ * Answer a derivation from the memo if one is set and has judged an
+ * equivalent derivation, attaching the auxiliary data found then
+ */
 bool
-CXXParser::DeclSpecifier::end(
-        ParseState &state  ///< the current parsing state
+CXXParser::recall(
+        ParseState &state,
+        bool       &accepted
 )
 {
-        SPPFNode::ConstPtr decl_spec_seq = state.parsedNode();
-        bool               ok            = true;
+        SPPFNode::ConstPtr node = state.parsedNode();
 
-        if (decl_spec_seq) {
-                CXXParser &cxx = CXXParser::getFrom(state);
-                Ptr        me  = new this_t;
+        if (!memo_ || !node || node->empty()) {
+                return false;
+        }
 
-                for (const SPPFNode &spec: subProductions(decl_spec_seq)) {
-                        ok = me->addDeclSpecifier(cxx, spec) && ok;
-                }
+        auto entry = memo_->recall(state.nonTerminal(), *node);
 
-                if (ok) {
-                        state.parsedNode()->setAuxData(me);
-                }
+        if (!entry) {
+                return false;
         }
 
-        return ok;
+        accepted = entry->accepted;
+
+        if (accepted && entry->aux) {
+                node->setAuxData(entry->aux);
+        }
+
+        return true;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::DeclSpecifier::addDeclSpecifier(
-        CXXParser      &cxx,
-        const SPPFNode &spec
+void
+CXXParser::remember(
+        ParseState         &state,
+        const AuxData::Ptr &aux,
+        bool                accepted
 )
 {
-        SPPFNode::ConstPtr match;
-        bool               apply = true;
+        SPPFNode::ConstPtr node = state.parsedNode();
 
-        if (spec.is(cxx.type_qualifier)) {
-                type_qual |= qualifierForToken(*spec.firstToken());
-        } else if (spec.is(cxx.simple_type_specifier, match)) {
-                Type type = NO_TYPE;
-                Size size = NO_SIZE;
-                Sign sign = NO_SIGN;
+        if (memo_ && node && !node->empty()) {
+                memo_->remember(state.nonTerminal(), *node, aux, accepted);
+        }
+}
 
-                switch (spec.firstToken()->kind()) {
-                        case TOK_KW_VOID:     type = VOID; break;
-                        case TOK_KW_AUTO:     type = AUTO; break;
-                        case TOK_KW_DECLTYPE: type = DECLTYPE; break;
-                        case TOK_KW_BOOL:     type = BOOL; break;
-                        case TOK_KW_CHAR:     type = CHAR; break;
-                        case TOK_KW_CHAR16_T: type = CHAR16_T; break;
-                        case TOK_KW_CHAR32_T: type = CHAR32_T; break;
-                        case TOK_KW_WCHAR_T:  type = WCHAR_T; break;
-                        case TOK_KW_INT:      type = INT; break;
-                        case TOK_KW_FLOAT:    type = FLOAT; break;
-                        case TOK_KW_DOUBLE:   type = DOUBLE; break;
-                        case TOK_KW_SHORT:    size = SHORT; break;
-                        case TOK_KW_LONG:
-                                if (spec.is(TOK_KW_LONG)) {
-                                        size = LONG;
-                                } else {
-                                        size = LONG_LONG;
-                                }
-                                break;
-                        case TOK_KW_SIGNED:   sign = SIGNED; break;
-                        case TOK_KW_UNSIGNED: sign = UNSIGNED; break;
-                        case TOK_IDENTIFIER:
-                                if (*spec.firstToken() == "nullptr_t") {
-                                        type = NULLPTR_T;
-                                        break;
-                                } // else fall through
-                        default:
-                                type = OTHER;
-                                break;
+//--------------------------------------
+/**
+ * \brief register a disambiguation filter
+ *
+ * Filters on a nonterminal are consulted in the order added whenever a
+ * derivation of it completes over the same tokens as an earlier derivation;
+ * the first filter expressing a preference decides. A derivation losing to
+ * one already in the forest is rejected at once, so the ambiguity never
+ * reaches enclosing nonterminals. The forest cannot be pruned once a
+ * derivation has been accepted, however, so a preferred derivation
+ * completing after a dispreferred one leaves the ambiguity in place and is
+ * only counted (as \c Filter::unresolved).
+ *
+ * The first call switches to a grammar with filtering actions registered;
+ * \c nonterminal may belong to the grammar in use beforehand.
+ */
+WRPARSECXX_API CXXParser &
+CXXParser::addFilter(
+        const char        *name,
+        const NonTerminal &nonterminal,
+        Filter::Compare    compare
+)
+{
+        if (!(grammar_->hooks() & Grammar::FILTERING)) {
+                useGrammar(grammar_->hooks() | Grammar::FILTERING);
+        }
+
+        const NonTerminal *target = grammar_->find(nonterminal.name());
+
+        Filter filter;
+        filter.name        = name;
+        filter.nonterminal = target ? target : &nonterminal;
+        filter.compare     = compare;
+        filters_.push_back(filter);
+        return *this;
+}
+
+//--------------------------------------
+
+/*
+ * switch to the shared grammar having the given hooks, updating filters to
+ * refer to its nonterminals
+ */
+void
+CXXParser::useGrammar(
+        uint8_t hooks
+)
+{
+        grammar_ = Grammar::get(options_, hooks);
+
+        for (Filter &filter: filters_) {
+                if (auto nt = grammar_->find(filter.nonterminal->name())) {
+                        filter.nonterminal = nt;
                 }
+        }
+}
 
-                if (type) {
-                        if (type_spec) {
-                                if (type_spec_node == &spec) {
-                                        return true;
-                                } else if (type == OTHER) {
-                                        /* if (type == OTHER) stop parsing
-                                           as this is probably the beginning
-                                           of a declarator */
-                                        return false;
-                                } else if (type_spec_node == &spec) {
-                                        // same type already specified elsewhere
-                                        cxx.emit(Diagnostic::ERROR, spec,
-                                                 "redundant type specifier \"%s\"",
-                                                 spec);
-                                        return true;  // but carry on parsing
-                                } else {
-                                        cxx.emit(Diagnostic::ERROR, spec,
-                                                 "\"%s\" conflicts with earlier type specifier \"%s\"",
-                                                 spec, *type_spec_node);
-                                        return true;
-                                }
-                        }
+//--------------------------------------
+/**
+ * \brief register filters implementing the standard's disambiguation rules
+ *
+ * - \c declaration-over-expression: a statement that can be either a
+ *   declaration or an expression is a declaration [stmt.ambig]
+ * - \c longest-declarator: a construct that can be a function declaration
+ *   or an object with an initializer is a declaration [dcl.ambig.res]
+ * - \c type-id-over-expression: a template argument that can be a type-id
+ *   is one [temp.arg]
+ */
+WRPARSECXX_API CXXParser &
+CXXParser::addStandardFilters()
+{
+        addFilter("declaration-over-expression", grammar_->statement,
+                  &preferDeclaration);
+        addFilter("declaration-over-expression", grammar_->for_init_statement,
+                  &preferDeclaration);
+        addFilter("longest-declarator", grammar_->init_declarator,
+                  &preferLongestDeclarator);
+        addFilter("longest-declarator", grammar_->member_declarator,
+                  &preferLongestDeclarator);
+        addFilter("longest-declarator", grammar_->parameter_declaration,
+                  &preferLongestDeclarator);
+        addFilter("type-id-over-expression", grammar_->template_argument,
+                  &preferTypeId);
+        return *this;
+}
 
-                        switch (type) {
-                        default:
-                                assert(false);
-                                break;
-                        case VOID: case AUTO: case DECLTYPE: case BOOL:
-                        case CHAR16_T: case CHAR32_T: case WCHAR_T:
-                        case FLOAT: case NULLPTR_T: case OTHER:
-                                if (sign_spec) {
-                                        cxx.emit(Diagnostic::ERROR,
-                                                 *sign_spec_node,
-                                                 "\"%s\" modifier cannot be used with type \"%s\"",
-                                                 sign_spec, spec);
-                                        apply = false;
-                                }
-                                if (size_spec) {
-                                        cxx.emit(Diagnostic::ERROR,
-                                                 *size_spec_node,
-                                                 "\"%s\" modifier cannot be used with type \"%s\"",
-                                                 size_spec, spec);
-                                        apply = false;
-                                }
-                                break;
-                        case CHAR:
-                                if (size_spec) {
-                                        cxx.emit(Diagnostic::ERROR,
-                                                 *size_spec_node,
-                                                 "\"%s\" modifier cannot be used with type \"char\"",
-                                                 size_spec);
-                                        return true;
-                                }
-                                break;
-                        case INT:
-                                break;
-                        case DOUBLE:
-                                if (sign_spec) {
-                                        cxx.emit(Diagnostic::ERROR,
-                                                 *sign_spec_node,
-                                                 "\"%s\" modifier cannot be used with type \"double\"",
-                                                 sign_spec);
-                                        apply = false;
-                                }
-                                if (size_spec && (size_spec != LONG)) {
-                                        cxx.emit(Diagnostic::ERROR,
-                                                 *size_spec_node,
-                                                 "\"%s\" modifier cannot be used with type \"double\"",
-                                                 size_spec);
-                                        apply = false;
-                                }
-                                break;
-                        }
+//--------------------------------------
 
-                        if (apply) {
-                                type_spec = type;
-                                type_spec_node = &spec;
-                        }
-                } else if (size) {
-                        if (size_spec && (size != size_spec)) {
-                                cxx.emit(Diagnostic::ERROR, spec,
-                                         "\"%s\" conflicts with earlier \"%s\" modifier",
-                                         size, size_spec);
-                                return true;
-                        }
+bool
+CXXParser::applyFilters(
+        ParseState &state  ///< the current parsing state
+)
+{
+        SPPFNode::ConstPtr node = state.parsedNode();
 
-                        switch (size) {
-                        default:
-                                assert(false);
-                                break;
-                        case SHORT: case LONG_LONG:
-                                if (type_spec && type_spec != INT) {
-                                        cxx.emit(Diagnostic::ERROR, spec,
-                                                 "\"%s\" modifier cannot be used with type \"%s\"",
-                                                 size, *type_spec_node);
-                                        return true;
-                                }
-                                break;
-                        case LONG:
-                                if (type_spec && (type_spec != INT)
-                                              && (type_spec != DOUBLE)) {
-                                        cxx.emit(Diagnostic::ERROR, spec,
-                                                 "\"%s\" modifier cannot be used with type \"%s\"",
-                                                 size, *type_spec_node);
-                                        return true;
-                                }
-                                break;
-                        }
+        if (!node || node->empty()) {
+                return true;
+        }
 
-                        size_spec = size;
-                        size_spec_node = &spec;
-                } else if (sign) {
-                        if (sign_spec && (sign != sign_spec)) {
-                                cxx.emit(Diagnostic::ERROR, spec,
-                                         "\"%s\" conflicts with earlier modifier \"%s\"",
-                                         sign, sign_spec);
-                                apply = false;
-                        }
-                        if (type_spec && (type_spec != INT)
-                                      && (type_spec != CHAR)) {
-                                cxx.emit(Diagnostic::ERROR, spec,
-                                         "\"%s\" modifier cannot be used with type \"%s\"",
-                                         sign, *type_spec_node);
-                                apply = false;
-                        }
+        auto &cxx      = CXXParser::getFrom(state);
+        bool  filtered = false;
 
-                        if (apply) {
-                                sign_spec = sign;
-                                sign_spec_node = &spec;
-                        }
+        for (const Filter &filter: cxx.filters_) {
+                if (filter.nonterminal == &state.nonTerminal()) {
+                        filtered = true;
+                        break;
                 }
-        } else if (spec.is(cxx.type_specifier)) {
-                /* elaborated-type-specifier, typename-specifier,
-                   enum-specifier or class-specifier */
-                if (type_spec) {
-                        return type_spec_node == &spec;
+        }
+
+        if (!filtered) {
+                return true;  // grammar hooks every nonterminal
+        }
+
+        /* derivations of a nonterminal over the same tokens are packed
+           children of one node, the derivation just completed last */
+        std::vector<const SPPFNode *> packed;
+
+        for (const SPPFNode &child: *node) {
+                if (child.isPackedNode()) {
+                        packed.push_back(&child);
                 }
-                if (sign_spec) {
-                        cxx.emit(Diagnostic::ERROR, spec,
-                                 "\"%s\" modifier cannot be used with type \"%s\"",
-                                 sign_spec, *type_spec_node);
-                        apply = false;
-                } else if (size_spec) {
-                        cxx.emit(Diagnostic::ERROR, spec,
-                                 "\"%s\" modifier cannot be used with type \"%s\"",
-                                 size_spec, *type_spec_node);
-                        apply = false;
+        }
+
+        if (packed.size() < 2) {
+                return true;
+        }
+
+        const SPPFNode &added = *packed.back();
+
+        packed.pop_back();
+
+        for (Filter &filter: cxx.filters_) {
+                if (filter.nonterminal != &state.nonTerminal()) {
+                        continue;
                 }
 
-                if (apply) {
-                        type_spec = OTHER;
-                        type_spec_node = &spec;
+                for (const SPPFNode *earlier: packed) {
+                        ++filter.examined;
+                        int preference = filter.compare(cxx, added, *earlier);
+
+                        if (preference < 0) {
+                                ++filter.discarded;
+                                return false;
+                        } else if (preference > 0) {
+                                ++filter.unresolved;
+                        }
                 }
         }
 
@@ -1924,397 +2410,1906 @@ CXXParser::DeclSpecifier::addDeclSpecifier(
 }
 
 //--------------------------------------
-/**
- * \brief find a declarator node's rightmost ptr-operator
- *
- * Looks for the rightmost ptr-operator (*, &amp;, &amp;&amp; or X::*) directly
- * under a declarator, abstract-declarator, new-declarator or
- * conversion-declarator node.
- *
- * \param [in] cxx
- *      parser object for referencing the C++ grammar nonterminals
- * \param [in] dcl_node
- *      declarator node to search under
- * \return
- *      pointer to rightmost ptr-operator node if it exists,
- *      \c nullptr otherwise
- * \note
- *      Nested declarators are not searched so this function will return a
- *      null pointer given a declarator node parsed from <code>int (*p)</code>,
- *      for example.
- */
-WRPARSECXX_API const SPPFNode *
-CXXParser::Declarator::lastPtrOperator(
+
+int
+CXXParser::preferDeclaration(
         CXXParser      &cxx,
-        const SPPFNode &dcl_node
-) // static
+        const SPPFNode &added,
+        const SPPFNode &earlier
+)
 {
-        const SPPFNode *ptr_op = nullptr;
+        auto is_decl = [&](const SPPFNode &node) -> int {
+                return node.find(cxx.grammar().declaration_statement, 1)
+                        || node.find(cxx.grammar().simple_declaration, 1);
+        };
 
-        // ptr_operators always come first
-        for (const SPPFNode &i: subProductions(dcl_node)) {
-                if (i.is(cxx.ptr_operator)) {
-                        ptr_op = &i;
-                } else {
-                        break;
-                }
+        return is_decl(added) - is_decl(earlier);
+}
+
+//--------------------------------------
+
+int
+CXXParser::preferLongestDeclarator(
+        CXXParser      &cxx,
+        const SPPFNode &added,
+        const SPPFNode &earlier
+)
+{
+        auto end_of = [&](const SPPFNode &node) -> size_t {
+                auto dcl = node.find(cxx.grammar().declarator, 1);
+                if (!dcl) {
+                        dcl = node.find(cxx.grammar().abstract_declarator, 1);
+                }
+                return (dcl && !dcl->empty()) ?
+                        dcl->lastToken()->offset() + 1 : 0;
+        };
+
+        size_t added_end   = end_of(added),
+               earlier_end = end_of(earlier);
+
+        return (added_end > earlier_end) - (added_end < earlier_end);
+}
+
+//--------------------------------------
+
+int
+CXXParser::preferTypeId(
+        CXXParser      &cxx,
+        const SPPFNode &added,
+        const SPPFNode &earlier
+)
+{
+        return int(!!added.find(cxx.grammar().type_id, 1))
+                - int(!!earlier.find(cxx.grammar().type_id, 1));
+}
+
+//--------------------------------------
+
+/**
+ * \brief retrieve the tokens of a function body skipped in
+ *      \c cxx::SKIP_FUNCTION_BODIES mode
+ *
+ * \param [in] function_body
+ *      parsed \c function_body node
+ * \return
+ *      the skipped body, or \c nullptr if \c function_body was parsed in
+ *      full; remains owned by \c *this until clearSkippedBodies()
+ */
+WRPARSECXX_API SkippedBody *
+CXXParser::skippedBody(
+        const SPPFNode &function_body
+) const
+{
+        const Token *token = function_body.lastToken();
+
+        if (!token || !token->is(TOK_SKIPPED_BODY)) {
+                return nullptr;
+        }
+
+        auto i = skipped_bodies_.find(token->offset());
+        return (i != skipped_bodies_.end()) ? i->second.get() : nullptr;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API CXXParser &
+CXXParser::clearSkippedBodies()
+{
+        skipped_bodies_.clear();
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief retrieve the elements of an initializer list read in
+ *      \c cxx::LITERAL_LISTS mode
+ *
+ * \param [in] braced_init_list
+ *      parsed \c braced_init_list node
+ * \return
+ *      the list's elements, or \c nullptr if \c braced_init_list was parsed
+ *      in full; remains owned by \c *this until clearLiteralLists()
+ */
+WRPARSECXX_API LiteralList *
+CXXParser::literalList(
+        const SPPFNode &braced_init_list
+) const
+{
+        const Token *token = braced_init_list.firstToken();
+
+        if (token) {
+                token = token->next();
+        }
+        if (!token || !token->is(TOK_LITERAL_LIST)) {
+                return nullptr;
+        }
+
+        auto i = literal_lists_.find(token->offset());
+        return (i != literal_lists_.end()) ? i->second.get() : nullptr;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API CXXParser &
+CXXParser::clearLiteralLists()
+{
+        literal_lists_.clear();
+        return *this;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::profileEnter(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+
+        if (cxx.profile_) {
+                cxx.profile_->enter(state.nonTerminal(), state.input());
+        }
+
+        return true;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::profileLeave(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+
+        if (cxx.profile_) {
+                // the input has moved on past the node by now
+                SPPFNode::ConstPtr node  = state.parsedNode();
+                const Token       *start = (node && !node->empty()) ?
+                                           node->firstToken() : state.input();
+
+                cxx.profile_->leave(state.nonTerminal(), start, node.get());
+        }
+
+        return true;
+}
+
+//--------------------------------------
+
+/*
+ * Retrieve a node's auxiliary data if it is of type T; the tag makes this
+ * a single comparison. Only the parser attaches data to the nodes passed
+ * here, which debug builds check.
+ */
+template <typename T> static T *
+auxDataAs(
+        const SPPFNode &node
+)
+{
+        AuxData *aux = node.auxData().get();
+
+        if (!aux) {
+                return nullptr;
+        }
+
+        assert(dynamic_cast<CXXParser::AuxBase *>(aux));
+
+        auto base = static_cast<CXXParser::AuxBase *>(aux);
+
+        return (base->aux_kind == T::KIND) ? static_cast<T *>(base) : nullptr;
+}
+
+//--------------------------------------
+
+template <> WRPARSECXX_API CXXParser::DeclSpecifier *
+CXXParser::get(
+        const SPPFNode &decl_spec_seq
+)
+{
+        return auxDataAs<DeclSpecifier>(decl_spec_seq);
+}
+
+//--------------------------------------
+
+/**
+ * \brief retrieve the data for a declarator node
+ *
+ * With \c cxx::DEFERRED_ACTIONS, data is built here on first request for
+ * nodes outside any parse result, without diagnostics.
+ */
+template <> WRPARSECXX_API CXXParser::Declarator *
+CXXParser::get(
+        const SPPFNode &declarator
+)
+{
+        Declarator *result = auxDataAs<Declarator>(declarator);
+
+        if (!result && !declarator.auxData()
+                    && options_.have(cxx::DEFERRED_ACTIONS)) {
+                Declarator::Ptr me = Declarator::build(*this, declarator,
+                                                       false);
+                if (me) {
+                        declarator.setAuxData(me);
+                        result = me.get();
+                }
+        }
+
+        return result;
+}
+
+//--------------------------------------
+
+/**
+ * \brief retrieve the data for a \c ptr_operator,
+ *      \c parameters_and_qualifiers or \c lambda_declarator node
+ *
+ * With \c cxx::DEFERRED_ACTIONS, data is built here on first request for
+ * nodes outside any parse result.
+ */
+template <> WRPARSECXX_API CXXParser::DeclaratorPart *
+CXXParser::get(
+        const SPPFNode &part
+)
+{
+        DeclaratorPart *result = auxDataAs<DeclaratorPart>(part);
+
+        if (!result && !part.auxData()
+                    && options_.have(cxx::DEFERRED_ACTIONS)) {
+                DeclaratorPart::Ptr me = DeclaratorPart::build(*this, part);
+                if (me) {
+                        part.setAuxData(me);
+                        result = me.get();
+                }
+        }
+
+        return result;
+}
+
+//--------------------------------------
+
+uint8_t
+CXXParser::qualifierForToken(
+        const Token &token
+)
+{
+        switch (token.kind()) {
+        case TOK_KW_CONST:
+                return CONST;
+        case TOK_KW_VOLATILE:
+                return VOLATILE;
+        case TOK_KW_RESTRICT:
+                return RESTRICT;
+        case TOK_KW_ATOMIC:
+                return ATOMIC;
+        case TOK_AMP:
+                return LVAL_REF;
+        case TOK_AMPAMP:
+                return RVAL_REF;
+        default:
+                return 0;
+        }
+}
+
+//--------------------------------------
+
+uint8_t
+CXXParser::typeQualifiersFromSeq(
+        const SPPFNode &type_qualifier_seq
+)
+{
+        uint8_t qualifiers = 0;
+
+        for (const SPPFNode &qualifier: subProductions(type_qualifier_seq)) {
+                qualifiers |= qualifierForToken(*qualifier.firstToken());
+        }
+
+        return qualifiers;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::DeclSpecifier::end(
+        ParseState &state  ///< the current parsing state
+)
+{
+        SPPFNode::ConstPtr decl_spec_seq = state.parsedNode();
+        bool               ok            = true;
+
+        if (decl_spec_seq) {
+                CXXParser &cxx = CXXParser::getFrom(state);
+
+                if (cxx.recall(state, ok)) {
+                        return ok;
+                }
+
+                Ptr me = new (cxx.aux_arena_) this_t;
+
+                for (const SPPFNode &spec: subProductions(decl_spec_seq)) {
+                        ok = me->addDeclSpecifier(cxx, spec) && ok;
+                }
+
+                if (ok) {
+                        state.parsedNode()->setAuxData(me);
+                }
+
+                cxx.remember(state, me, ok);
+        }
+
+        return ok;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::DeclSpecifier::addDeclSpecifier(
+        CXXParser      &cxx,
+        const SPPFNode &spec
+)
+{
+        SPPFNode::ConstPtr match;
+        bool               apply = true;
+
+        if (spec.is(cxx.grammar().type_qualifier)) {
+                type_qual |= qualifierForToken(*spec.firstToken());
+        } else if (spec.is(cxx.grammar().simple_type_specifier, match)) {
+                Type type = NO_TYPE;
+                Size size = NO_SIZE;
+                Sign sign = NO_SIGN;
+
+                switch (spec.firstToken()->kind()) {
+                        case TOK_KW_VOID:     type = VOID; break;
+                        case TOK_KW_AUTO:     type = AUTO; break;
+                        case TOK_KW_DECLTYPE: type = DECLTYPE; break;
+                        case TOK_KW_BOOL:     type = BOOL; break;
+                        case TOK_KW_CHAR:     type = CHAR; break;
+                        case TOK_KW_CHAR16_T: type = CHAR16_T; break;
+                        case TOK_KW_CHAR32_T: type = CHAR32_T; break;
+                        case TOK_KW_WCHAR_T:  type = WCHAR_T; break;
+                        case TOK_KW_INT:      type = INT; break;
+                        case TOK_KW_FLOAT:    type = FLOAT; break;
+                        case TOK_KW_DOUBLE:   type = DOUBLE; break;
+                        case TOK_KW_SHORT:    size = SHORT; break;
+                        case TOK_KW_LONG:
+                                if (spec.is(TOK_KW_LONG)) {
+                                        size = LONG;
+                                } else {
+                                        size = LONG_LONG;
+                                }
+                                break;
+                        case TOK_KW_SIGNED:   sign = SIGNED; break;
+                        case TOK_KW_UNSIGNED: sign = UNSIGNED; break;
+                        case TOK_IDENTIFIER:
+                                if (*spec.firstToken() == "nullptr_t") {
+                                        type = NULLPTR_T;
+                                        break;
+                                } // else fall through
+                        default:
+                                type = OTHER;
+                                break;
+                }
+
+                if (type) {
+                        if (type_spec) {
+                                if (type_spec_node == &spec) {
+                                        return true;
+                                } else if (type == OTHER) {
+                                        /* if (type == OTHER) stop parsing
+                                           as this is probably the beginning
+                                           of a declarator */
+                                        return false;
+                                } else if (type_spec_node == &spec) {
+                                        // same type already specified elsewhere
+                                        cxx.emit(Diagnostic::ERROR, spec,
+                                                 "redundant type specifier \"%s\"",
+                                                 spec);
+                                        return true;  // but carry on parsing
+                                } else {
+                                        cxx.emit(Diagnostic::ERROR, spec,
+                                                 "\"%s\" conflicts with earlier type specifier \"%s\"",
+                                                 spec, *type_spec_node);
+                                        return true;
+                                }
+                        }
+
+                        switch (type) {
+                        default:
+                                assert(false);
+                                break;
+                        case VOID: case AUTO: case DECLTYPE: case BOOL:
+                        case CHAR16_T: case CHAR32_T: case WCHAR_T:
+                        case FLOAT: case NULLPTR_T: case OTHER:
+                                if (sign_spec) {
+                                        cxx.emit(Diagnostic::ERROR,
+                                                 *sign_spec_node,
+                                                 "\"%s\" modifier cannot be used with type \"%s\"",
+                                                 sign_spec, spec);
+                                        apply = false;
+                                }
+                                if (size_spec) {
+                                        cxx.emit(Diagnostic::ERROR,
+                                                 *size_spec_node,
+                                                 "\"%s\" modifier cannot be used with type \"%s\"",
+                                                 size_spec, spec);
+                                        apply = false;
+                                }
+                                break;
+                        case CHAR:
+                                if (size_spec) {
+                                        cxx.emit(Diagnostic::ERROR,
+                                                 *size_spec_node,
+                                                 "\"%s\" modifier cannot be used with type \"char\"",
+                                                 size_spec);
+                                        return true;
+                                }
+                                break;
+                        case INT:
+                                break;
+                        case DOUBLE:
+                                if (sign_spec) {
+                                        cxx.emit(Diagnostic::ERROR,
+                                                 *sign_spec_node,
+                                                 "\"%s\" modifier cannot be used with type \"double\"",
+                                                 sign_spec);
+                                        apply = false;
+                                }
+                                if (size_spec && (size_spec != LONG)) {
+                                        cxx.emit(Diagnostic::ERROR,
+                                                 *size_spec_node,
+                                                 "\"%s\" modifier cannot be used with type \"double\"",
+                                                 size_spec);
+                                        apply = false;
+                                }
+                                break;
+                        }
+
+                        if (apply) {
+                                type_spec = type;
+                                type_spec_node = &spec;
+                        }
+                } else if (size) {
+                        if (size_spec && (size != size_spec)) {
+                                cxx.emit(Diagnostic::ERROR, spec,
+                                         "\"%s\" conflicts with earlier \"%s\" modifier",
+                                         size, size_spec);
+                                return true;
+                        }
+
+                        switch (size) {
+                        default:
+                                assert(false);
+                                break;
+                        case SHORT: case LONG_LONG:
+                                if (type_spec && type_spec != INT) {
+                                        cxx.emit(Diagnostic::ERROR, spec,
+                                                 "\"%s\" modifier cannot be used with type \"%s\"",
+                                                 size, *type_spec_node);
+                                        return true;
+                                }
+                                break;
+                        case LONG:
+                                if (type_spec && (type_spec != INT)
+                                              && (type_spec != DOUBLE)) {
+                                        cxx.emit(Diagnostic::ERROR, spec,
+                                                 "\"%s\" modifier cannot be used with type \"%s\"",
+                                                 size, *type_spec_node);
+                                        return true;
+                                }
+                                break;
+                        }
+
+                        size_spec = size;
+                        size_spec_node = &spec;
+                } else if (sign) {
+                        if (sign_spec && (sign != sign_spec)) {
+                                cxx.emit(Diagnostic::ERROR, spec,
+                                         "\"%s\" conflicts with earlier modifier \"%s\"",
+                                         sign, sign_spec);
+                                apply = false;
+                        }
+                        if (type_spec && (type_spec != INT)
+                                      && (type_spec != CHAR)) {
+                                cxx.emit(Diagnostic::ERROR, spec,
+                                         "\"%s\" modifier cannot be used with type \"%s\"",
+                                         sign, *type_spec_node);
+                                apply = false;
+                        }
+
+                        if (apply) {
+                                sign_spec = sign;
+                                sign_spec_node = &spec;
+                        }
+                }
+        } else if (spec.is(cxx.grammar().type_specifier)) {
+                /* elaborated-type-specifier, typename-specifier,
+                   enum-specifier or class-specifier */
+                if (type_spec) {
+                        return type_spec_node == &spec;
+                }
+                if (sign_spec) {
+                        cxx.emit(Diagnostic::ERROR, spec,
+                                 "\"%s\" modifier cannot be used with type \"%s\"",
+                                 sign_spec, *type_spec_node);
+                        apply = false;
+                } else if (size_spec) {
+                        cxx.emit(Diagnostic::ERROR, spec,
+                                 "\"%s\" modifier cannot be used with type \"%s\"",
+                                 size_spec, *type_spec_node);
+                        apply = false;
+                }
+
+                if (apply) {
+                        type_spec = OTHER;
+                        type_spec_node = &spec;
+                }
+        }
+
+        return true;
+}
+
+//--------------------------------------
+/**
+ * \brief find a declarator node's rightmost ptr-operator
+ *
+ * Looks for the rightmost ptr-operator (*, &amp;, &amp;&amp; or X::*) directly
+ * under a declarator, abstract-declarator, new-declarator or
+ * conversion-declarator node.
+ *
+ * \param [in] cxx
+ *      parser object for referencing the C++ grammar nonterminals
+ * \param [in] dcl_node
+ *      declarator node to search under
+ * \return
+ *      pointer to rightmost ptr-operator node if it exists,
+ *      \c nullptr otherwise
+ * \note
+ *      Nested declarators are not searched so this function will return a
+ *      null pointer given a declarator node parsed from <code>int (*p)</code>,
+ *      for example.
+ */
+WRPARSECXX_API const SPPFNode *
+CXXParser::Declarator::lastPtrOperator(
+        CXXParser      &cxx,
+        const SPPFNode &dcl_node
+) // static
+{
+        const SPPFNode *ptr_op = nullptr;
+
+        // ptr_operators always come first
+        for (const SPPFNode &i: subProductions(dcl_node)) {
+                if (i.is(cxx.grammar().ptr_operator)) {
+                        ptr_op = &i;
+                } else {
+                        break;
+                }
+        }
+
+        return ptr_op;
+}
+
+//--------------------------------------
+/**
+ * \brief determine if a declarator node is a reference
+ *
+ * \param [in] cxx
+ *      parser object for referencing the C++ grammar nonterminals
+ * \param [in] dcl_node
+ *      declarator node
+ * \return
+ *      \c true if \c dcl_node is a reference declarator, \c false otherwise
+ * \note
+ *      Nested declarators are not searched so this function will return
+ *      \c false given a declarator node parsed from
+ *      <code>int (&amp;p)[]</code>, for example.
+ */
+WRPARSECXX_API bool
+CXXParser::Declarator::isReference(
+        CXXParser      &cxx,
+        const SPPFNode &dcl_node
+) // static
+{
+        const SPPFNode *last_ptr_op = lastPtrOperator(cxx, dcl_node);
+
+        if (last_ptr_op) {
+                const Token *token = last_ptr_op->firstToken();
+                if (token->is(TOK_AMP) || token->is(TOK_AMPAMP)) {
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::Declarator::end(
+        ParseState &state  ///< the current parsing state
+)
+{
+        SPPFNode::ConstPtr dcl_node = state.parsedNode();
+
+        if (!dcl_node) {
+                return true;
+        }
+
+        auto &cxx = CXXParser::getFrom(state);
+        bool  ok;
+
+        if (cxx.recall(state, ok)) {
+                return ok;
+        }
+
+        Ptr me = new (cxx.aux_arena_) this_t;
+
+        ok = me->check(cxx, *dcl_node, &state, true);
+        if (ok) {
+                dcl_node->setAuxData(me);
+        }
+
+        cxx.remember(state, me, ok);
+        return ok;
+}
+
+//--------------------------------------
+
+/*
+ * Diagnostics are reported through \c state if given, otherwise through
+ * the parser against the offending node, and only if \c diagnose is set
+ */
+bool
+CXXParser::Declarator::check(
+        CXXParser      &cxx,
+        const SPPFNode &dcl_node,
+        ParseState     *state,
+        bool            diagnose
+)
+{
+        auto &gram = cxx.grammar();
+
+        auto error = [&](const SPPFNode *at, const char *message) {
+                if (!diagnose) {
+                        return;
+                } else if (!state) {
+                        cxx.emit(Diagnostic::ERROR, at ? *at : dcl_node,
+                                 message);
+                } else if (at) {
+                        state->emit(Diagnostic::ERROR, *at, message);
+                } else {
+                        state->emit(Diagnostic::ERROR, message);
+                }
+        };
+
+        SPPFNode::ConstPtr  nested_dcl     = nullptr;
+        const Token        *ref_op         = nullptr;
+        bool                ref_to_ref     = false,
+                            ptr_to_ref     = false,
+                            multi_fn_parms = false,
+                            array_of_refs  = false;
+
+        for (const SPPFNode &part: subProductions(dcl_node)) {
+                if (part.is(gram.ptr_operator)) {
+                        if (part.firstToken()->is(TOK_AMP)
+                                        || part.firstToken()->is(TOK_AMPAMP)) {
+                                if (!ref_op) {
+                                        ref_op = part.firstToken();
+                                } else if (!ref_to_ref) {
+                                        error(nullptr,
+                                              "reference to reference not permitted");
+                                        ref_to_ref = true;
+                                }
+                        } else if (ref_op && !ptr_to_ref) {
+                                error(nullptr,
+                                      "pointer to reference not permitted");
+                                ptr_to_ref = true;
+                        }
+                        last_ptr = part.firstToken();
+                } else if (part.is(gram.parameters_and_qualifiers)) {
+                        if (!begin_parms) {
+                                begin_parms = part.firstToken();
+                                        /* = first token of
+                                             parameter-declaration-clause */
+                        } else if (!multi_fn_parms) {
+                                error(&part,
+                                      "multiple sets of function parameters/qualifiers");
+                                multi_fn_parms = true;
+                        }
+                } else if (part.is(gram.array_declarator)) {
+                        if (ref_op && !array_of_refs) {
+                                error(nullptr,
+                                      "array of references not permitted");
+                                array_of_refs = true;
+                        }
+                        array = true;
+                } else if (part.is(gram.nested_declarator)
+                                || part.is(gram.nested_abstract_declarator)) {
+                        nested_dcl = &part;
+                }
+        }
+
+        if (nested_dcl) {
+                return check(cxx, *nested_dcl, state, diagnose);
+        }
+
+        return true;
+}
+
+//--------------------------------------
+
+/*
+ * Build the data for a node of any of the declarator nonterminals, or
+ * return nullptr if \c dcl_node is not one
+ */
+CXXParser::Declarator::Ptr
+CXXParser::Declarator::build(
+        CXXParser      &cxx,
+        const SPPFNode &dcl_node,
+        bool            diagnose
+) // static
+{
+        auto &gram = cxx.grammar();
+
+        if (!dcl_node.is(gram.declarator)
+                        && !dcl_node.is(gram.nested_declarator)
+                        && !dcl_node.is(gram.abstract_declarator)
+                        && !dcl_node.is(gram.nested_abstract_declarator)
+                        && !dcl_node.is(gram.new_declarator)
+                        && !dcl_node.is(gram.conversion_declarator)) {
+                return nullptr;
+        }
+
+        Ptr me = new (cxx.aux_arena_) this_t;
+
+        me->check(cxx, dcl_node, nullptr, diagnose);
+        return me;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::Declarator::isFunction(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto               &cxx      = CXXParser::getFrom(state);
+        SPPFNode::ConstPtr  dcl_node = state.parsedNode();
+        return dcl_node
+                && (dcl_node->find(cxx.grammar().parameters_and_qualifiers)
+                    != nullptr);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API bool
+CXXParser::DeclaratorPart::isParmPackOperator(
+        CXXParser      &cxx,
+        const SPPFNode &part
+)
+{
+        return (part.is(cxx.grammar().declarator_id)
+                                && part.firstToken()->is(TOK_ELLIPSIS))
+               || part.is(cxx.grammar().abstract_pack_declarator);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::DeclaratorPart::endParametersAndQualifiers(
+        ParseState &state  ///< the current parsing state
+)
+{
+        SPPFNode::ConstPtr result = state.parsedNode();
+
+        if (!result) {
+                return false;
+        }
+
+        result->setAuxData(forParametersAndQualifiers(
+                                        CXXParser::getFrom(state), *result));
+        return true;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::DeclaratorPart::endPtrOperator(
+        ParseState &state  ///< the current parsing state
+)
+{
+        SPPFNode::ConstPtr result = state.parsedNode();
+
+        if (!result) {  // didn't match
+                return false;
+        }
+
+        result->setAuxData(forPtrOperator(CXXParser::getFrom(state),
+                                          *result));
+        return true;
+}
+
+//--------------------------------------
+
+CXXParser::DeclaratorPart::Ptr
+CXXParser::DeclaratorPart::forParametersAndQualifiers(
+        CXXParser      &cxx,
+        const SPPFNode &part
+) // static
+{
+        Ptr                me    = new (cxx.aux_arena_) this_t;
+        SPPFNode::ConstPtr parms = nonTerminals(part).node();
+
+        if (parms && parms->is(cxx.grammar().parameter_declaration_clause)) {
+                if (parms->empty()) {
+                        me->count = 0;
+                } else if (!parms->hasChildren()) {
+                        me->count = 1;
+                } else {
+                        me->count = numeric_cast<unsigned short>(
+                                                      countNonTerminals(parms));
+                }
+                me->variadic = !parms->empty()
+                                && parms->lastToken()->is(TOK_ELLIPSIS);
+        }
+
+        for (const SPPFNode &quals: nonTerminals(part)) {
+                if (quals.is(cxx.grammar().type_qualifier_seq)) {
+                        me->qualifiers |= typeQualifiersFromSeq(quals);
+                } else if (quals.is(cxx.grammar().ref_qualifier)) {
+                        me->qualifiers
+                                |= qualifierForToken(*quals.firstToken());
+                }
+        }
+
+        return me;
+}
+
+//--------------------------------------
+
+CXXParser::DeclaratorPart::Ptr
+CXXParser::DeclaratorPart::forPtrOperator(
+        CXXParser      &cxx,
+        const SPPFNode &part
+) // static
+{
+        Ptr  me         = new (cxx.aux_arena_) this_t;
+        auto type_quals = part.find(cxx.grammar().type_qualifier_seq, 1);
+
+        if (type_quals) {
+                me->qualifiers = typeQualifiersFromSeq(*type_quals);
+        }
+
+        return me;
+}
+
+//--------------------------------------
+
+/*
+ * Build the data for a node of any nonterminal having DeclaratorPart data,
+ * or return nullptr if \c part is not one
+ */
+CXXParser::DeclaratorPart::Ptr
+CXXParser::DeclaratorPart::build(
+        CXXParser      &cxx,
+        const SPPFNode &part
+) // static
+{
+        auto &gram = cxx.grammar();
+
+        if (part.is(gram.ptr_operator)) {
+                return forPtrOperator(cxx, part);
+        } else if (part.is(gram.parameters_and_qualifiers)
+                        || part.is(gram.lambda_declarator)) {
+                return forParametersAndQualifiers(cxx, part);
+        } else {
+                return nullptr;
+        }
+}
+
+//--------------------------------------
+
+/*
+ * In C, struct/union/enum tags are looked up separately from ordinary
+ * identifiers (variables, functions, enumerators and typedef names)
+ */
+static const uint8_t C_ORDINARY = SymbolTable::OBJECT | SymbolTable::TYPEDEF;
+
+//--------------------------------------
+
+const SymbolTable::Symbol *
+CXXParser::lookupName(
+        const Token &name,
+        uint8_t      kinds
+) const
+{
+        return symbols_.lookup(name.spelling(), name.offset(), kinds);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isTypedefName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        auto  sym = cxx.lookupName(*state.input(), cxx.langCXX() ?
+                                        uint8_t(SymbolTable::ANY) : C_ORDINARY);
+        return sym && (sym->kind & SymbolTable::TYPEDEF);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isClassName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        return cxx.lookupName(*state.input(), SymbolTable::CLASS) != nullptr;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isEnumName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        return cxx.lookupName(*state.input(), SymbolTable::ENUM) != nullptr;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isNamespaceName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        auto  sym = cxx.lookupName(*state.input(), SymbolTable::ANY);
+        return sym && (sym->kind & SymbolTable::NAMESPACE);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isNamespaceAliasName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        auto  sym = cxx.lookupName(*state.input(), SymbolTable::ANY);
+        return sym && (sym->kind & SymbolTable::NAMESPACE_ALIAS);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isTemplateName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        auto  sym = cxx.lookupName(*state.input(), SymbolTable::ANY);
+
+        if (!sym) {
+                return false;
+        } else if (sym->kind & SymbolTable::TEMPLATE) {
+                return true;
+        }
+
+        /* a class template's name is not known to be a template until the
+           whole template-declaration has been parsed, but may be used as
+           such within its own definition */
+        return (sym->kind & SymbolTable::CLASS)
+                && cxx.symbols_.inTemplate(sym->offset);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isUndeclaredName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        auto &cxx = CXXParser::getFrom(state);
+        return !cxx.lookupName(*state.input(), cxx.langCXX() ?
+                                        uint8_t(SymbolTable::ANY) : C_ORDINARY);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isClassHeadName(
+        ParseState &state  ///< the current parsing state
+)
+{
+        return !isClassName(state);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isFinalSpecifier(
+        ParseState &state  ///< the current parsing state
+)
+{
+        return *state.input() == u8"final";
+}
+
+//--------------------------------------
+
+/*
+ * Fast path for lone expression operands: an identifier or literal followed
+ * by a token that cannot continue an expression is parsed directly as a
+ * primary-expression, rather than through the fifteen or so levels of the
+ * binary operator precedence chain. Everything else, including every
+ * expression having a binary operator, takes the full chain.
+ *
+ * The token following the operand is read from the lexer here if no parse
+ * has reached it yet, so that isSimpleOperand() and isCompoundOperand()
+ * decide on the same token whenever each is evaluated, and exactly one of
+ * the two paths is taken.
+ */
+static bool
+isSimpleOperandToken(
+        ParseState &state
+)
+{
+        Token *token = state.input();
+
+        switch (token->kind()) {
+        case TOK_IDENTIFIER:
+        case TOK_DEC_INT_LITERAL: case TOK_HEX_INT_LITERAL:
+        case TOK_OCT_INT_LITERAL: case TOK_BIN_INT_LITERAL:
+        case TOK_FLOAT_LITERAL:
+        case TOK_CHAR_LITERAL: case TOK_WCHAR_LITERAL:
+        case TOK_U8_CHAR_LITERAL: case TOK_U16_CHAR_LITERAL:
+        case TOK_U32_CHAR_LITERAL:
+        case TOK_STR_LITERAL: case TOK_WSTR_LITERAL:
+        case TOK_U8_STR_LITERAL: case TOK_U16_STR_LITERAL:
+        case TOK_U32_STR_LITERAL:
+        case TOK_KW_TRUE: case TOK_KW_FALSE: case TOK_KW_NULLPTR:
+        case TOK_KW_THIS:
+                break;
+        default:
+                return false;
+        }
+
+        if (!token->next() && state.parser().lexer()) {
+                auto &tokens = state.parser().tokens();
+                Token t;
+
+                do {
+                        state.parser().lexer()->lex(t);
+                } while (t.flags() & TF_PREPROCESS);
+
+                tokens.emplace_after(tokens.make_iterator(token), t);
+        }
+
+        const Token *next = token->next();
+
+        if (!next) {
+                return false;
+        }
+
+        switch (next->kind()) {
+        case TOK_RPAREN: case TOK_RSQUARE: case TOK_RBRACE:
+        case TOK_COMMA: case TOK_SEMI: case TOK_COLON:
+                return true;
+        default:
+                return false;
+        }
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isSimpleOperand(
+        ParseState &state  ///< the current parsing state
+)
+{
+        return isSimpleOperandToken(state);
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isCompoundOperand(
+        ParseState &state  ///< the current parsing state
+)
+{
+        return !isSimpleOperandToken(state);
+}
+
+//--------------------------------------
+
+/*
+ * Read tokens straight from the lexer, passing over preprocessing
+ * directives, up to the bracket closing one of kind open already read,
+ * handing each token before it to visit. Returns true with the closing
+ * bracket in t, or false with TOK_EOF in t if the input ends first.
+ */
+template <typename Visitor> static bool
+readToClosingBracket(
+        Lexer     &lexer,
+        TokenKind  open,
+        TokenKind  close,
+        Token     &t,
+        Visitor    visit
+)
+{
+        for (size_t depth = 1;;) {
+                lexer.lex(t);
+
+                if (t.is(TOK_EOF)) {
+                        return false;
+                } else if (t.flags() & TF_PREPROCESS) {
+                        continue;
+                } else if (t.is(open)) {
+                        ++depth;
+                } else if (t.is(close) && !--depth) {
+                        return true;
+                }
+
+                visit(t);
+        }
+}
+
+//--------------------------------------
+
+/*
+ * SKIP_FUNCTION_BODIES mode: on reaching the '{' of a function body, read
+ * the body's tokens straight from the lexer up to the matching '}' and
+ * collapse them into the '{' token, which becomes TOK_SKIPPED_BODY. This is
+ * only possible while no parse has looked beyond the '{', as tokens already
+ * in the parser's token list cannot be withdrawn; otherwise the body is
+ * parsed in full.
+ */
+bool
+CXXParser::skipFunctionBody(
+        ParseState &state  ///< the current parsing state
+)
+{
+        Token *token = state.input();
+
+        if (token->is(TOK_SKIPPED_BODY)) {
+                return true;  // skipped on behalf of another parse
+        } else if (!token->is(TOK_LBRACE) || token->next()
+                   || !state.parser().lexer()) {
+                return false;
+        }
+
+        auto  &cxx   = CXXParser::getFrom(state);
+        Lexer &lexer = *state.parser().lexer();
+        auto   body  = std::unique_ptr<SkippedBody>(new SkippedBody);
+        Token  t;
+
+        body->add(*token);
+
+        if (readToClosingBracket(lexer, TOK_LBRACE, TOK_RBRACE, t,
+                                 [&](const Token &read) { body->add(read); })) {
+                body->add(t);
+        } else {
+                state.emit(Diagnostic::ERROR,
+                           "end of input within function body");
+        }
+
+        setKindAndSpelling(*token, TOK_SKIPPED_BODY);
+        cxx.skipped_bodies_[token->offset()] = std::move(body);
+        return true;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::isBalancedToken(
+        ParseState &state  ///< the current parsing state
+)
+{
+        switch (state.input()->kind()) {
+        case TOK_LPAREN: case TOK_RPAREN: case TOK_LSQUARE: case TOK_RSQUARE:
+        case TOK_LBRACE: case TOK_RBRACE: case TOK_BALANCED_TOKEN_SEQ:
+                return false;
+        default:
+                return true;
+        }
+}
+
+//--------------------------------------
+
+/*
+ * Attribute arguments are opaque to the grammar, so rather than match them
+ * token by token through balanced-token, read them straight from the lexer
+ * up to the closing ')' and insert a single TOK_BALANCED_TOKEN_SEQ token
+ * whose spelling is their text. As with skipFunctionBody(), this is only
+ * possible while no parse has looked beyond the '('; otherwise the
+ * arguments are matched by the grammar as before.
+ */
+bool
+CXXParser::collapseBalancedTokens(
+        ParseState &state  ///< the current parsing state
+)
+{
+        Token *token = state.input();
+
+        if (!token->is(TOK_LPAREN) || token->next()
+            || !state.parser().lexer()) {
+                return true;
+        }
+
+        auto        &cxx   = CXXParser::getFrom(state);
+        Lexer       &lexer = *state.parser().lexer();
+        auto         pos   = state.parser().tokens().make_iterator(token);
+        Token        first, t;
+        std::string  text;
+
+        auto append = [&](const Token &read) {
+                if (text.empty()) {
+                        first = read;
+                } else if (read.flags() & TF_SPACE_BEFORE) {
+                        text += ' ';
+                }
+                text.append(read.spelling().char_data(),
+                            read.spelling().bytes());
+        };
+
+        if (!readToClosingBracket(lexer, TOK_LPAREN, TOK_RPAREN, t, append)) {
+                state.emit(Diagnostic::ERROR,
+                           "end of input within attribute arguments");
+        }
+
+        if (!text.empty()) {
+                cxx.collapsed_.emplace_front(std::move(text));
+                first.setKind(TOK_BALANCED_TOKEN_SEQ)
+                     .setSpelling(u8string_view(cxx.collapsed_.front()));
+                pos = state.parser().tokens().emplace_after(pos, first);
+        }
+
+        state.parser().tokens().emplace_after(pos, t);  // ')' or end of input
+        return true;
+}
+
+//--------------------------------------
+
+/*
+ * LITERAL_LISTS mode: on reaching the '{' of a braced-init-list, read ahead
+ * from the lexer for as long as the tokens form a comma-separated list of
+ * literals. If the list is closed by '}', keep its elements as a
+ * LiteralList and insert a single TOK_LITERAL_LIST token in their place, so
+ * that a data table of any length is parsed without descending through the
+ * expression grammar for each element. Otherwise return the tokens read to
+ * the parser's token list to be parsed as usual; holding them meanwhile
+ * costs no more than the token list itself would. As with
+ * skipFunctionBody(), this is only possible while no parse has looked
+ * beyond the '{'.
+ */
+bool
+CXXParser::collapseLiteralList(
+        ParseState &state  ///< the current parsing state
+)
+{
+        Token *token = state.input();
+
+        if (!token->is(TOK_LBRACE) || token->next()
+            || !state.parser().lexer()) {
+                return true;
+        }
+
+        auto               &cxx      = CXXParser::getFrom(state);
+        Lexer              &lexer    = *state.parser().lexer();
+        auto               &tokens   = state.parser().tokens();
+        auto                pos      = tokens.make_iterator(token);
+        auto                list     = std::unique_ptr<LiteralList>(
+                                                        new LiteralList);
+        std::vector<Token>  read;
+        Token               t;
+        bool                element  = true,   // element expected next
+                            sign     = false,  // after '+' or '-'
+                            complete = false;
+
+        for (;;) {
+                lexer.lex(t);
+
+                if (t.flags() & TF_PREPROCESS) {
+                        continue;
+                }
+
+                read.push_back(t);
+
+                if (!element) {
+                        if (t.is(TOK_COMMA)) {
+                                element = true;
+                                continue;
+                        }
+                        complete = t.is(TOK_RBRACE);
+                        break;
+                }
+
+                switch (t.kind()) {
+                case TOK_DEC_INT_LITERAL: case TOK_HEX_INT_LITERAL:
+                case TOK_OCT_INT_LITERAL: case TOK_BIN_INT_LITERAL:
+                case TOK_FLOAT_LITERAL:
+                        list->add(t, sign ? &read[read.size() - 2]
+                                          : nullptr);
+                        sign = false;
+                        element = false;
+                        continue;
+                case TOK_CHAR_LITERAL: case TOK_WCHAR_LITERAL:
+                case TOK_U8_CHAR_LITERAL: case TOK_U16_CHAR_LITERAL:
+                case TOK_U32_CHAR_LITERAL: case TOK_STR_LITERAL:
+                case TOK_WSTR_LITERAL: case TOK_U8_STR_LITERAL:
+                case TOK_U16_STR_LITERAL: case TOK_U32_STR_LITERAL:
+                case TOK_KW_TRUE: case TOK_KW_FALSE:
+                        if (sign) {
+                                break;
+                        }
+                        list->add(t);
+                        element = false;
+                        continue;
+                case TOK_PLUS: case TOK_MINUS:
+                        if (sign) {
+                                break;
+                        }
+                        sign = true;
+                        continue;
+                case TOK_RBRACE:  // after trailing comma
+                        complete = !sign && (list->size() != 0);
+                        break;
+                default:
+                        break;
+                }
+
+                break;
+        }
+
+        if (complete) {
+                Token collapsed = read.front();
+
+                collapsed.setKind(TOK_LITERAL_LIST)
+                         .setSpelling(list->text());
+                cxx.literal_lists_[collapsed.offset()] = std::move(list);
+                pos = tokens.emplace_after(pos, collapsed);
+                tokens.emplace_after(pos, read.back());  // '}'
+        } else {
+                for (const Token &r: read) {
+                        pos = tokens.emplace_after(pos, r);
+                }
+        }
+
+        return true;
+}
+
+//--------------------------------------
+
+bool
+CXXParser::processTemplParmArgListEndToken(
+        ParseState &state  ///< the current parsing state
+)
+{
+        if (CXXParser::getFrom(state).options_.cxx() < cxx::CXX11) {
+                return true;
+        }
+
+        auto token = state.parser().tokens().make_iterator(state.input());
+
+        TokenKind   new_kind;
+        const char *new_spelling;
+
+        switch (token->kind()) {
+        case TOK_GREATER:
+                return true;
+        case TOK_RSHIFT:
+                new_kind = TOK_GREATER, new_spelling = u8">";
+                break;
+        case TOK_GREATEREQUAL:
+                new_kind = TOK_EQUAL, new_spelling = u8"=";
+                break;
+        case TOK_RSHIFTEQUAL:
+                new_kind = TOK_GREATEREQUAL, new_spelling = u8">=";
+                break;
+        default:
+                return false;
+        }
+
+        if (!(token->flags() & cxx::TF_SPLITABLE)) {
+                return false;
         }
 
-        return ptr_op;
+        // split token in two
+        token->setKind(TOK_GREATER).setSpelling(u8">");
+        state.parser().tokens().emplace_after(token, *token)
+                ->setKind(new_kind).setSpelling(new_spelling).adjustOffset(1);
+        return true;
 }
 
 //--------------------------------------
-/**
- * \brief determine if a declarator node is a reference
+
+/*
+ * Symbol table maintenance
  *
- * \param [in] cxx
- *      parser object for referencing the C++ grammar nonterminals
- * \param [in] dcl_node
- *      declarator node
- * \return
- *      \c true if \c dcl_node is a reference declarator, \c false otherwise
- * \note
- *      Nested declarators are not searched so this function will return
- *      \c false given a declarator node parsed from
- *      <code>int (&amp;p)[]</code>, for example.
+ * Names are entered as the nonterminals declaring them are parsed; the name
+ * predicates above then let the parser discard alternatives such as the
+ * declaration interpretation of "a * b;" where "a" is a variable, or the
+ * template-id interpretation of "a < b > c" where "a" is not a template.
+ * Function parameters are not entered as they are rarely used to hide
+ * type names.
  */
-WRPARSECXX_API bool
-CXXParser::Declarator::isReference(
-        CXXParser      &cxx,
-        const SPPFNode &dcl_node
-) // static
+static const Token *
+identifierToken(
+        const SPPFNode *node
+)
 {
-        const SPPFNode *last_ptr_op = lastPtrOperator(cxx, dcl_node);
+        if (!node || node->empty()) {
+                return nullptr;
+        }
 
-        if (last_ptr_op) {
-                const Token *token = last_ptr_op->firstToken();
-                if (token->is(TOK_AMP) || token->is(TOK_AMPAMP)) {
-                        return true;
-                }
+        const Token *token = node->firstToken();
+
+        if ((token != node->lastToken()) || !token->is(TOK_IDENTIFIER)) {
+                return nullptr;
         }
 
-        return false;
+        return token;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::Declarator::end(
-        ParseState &state  ///< the current parsing state
+static const Token *
+declaratorName(
+        const CXXParser &cxx,
+        const SPPFNode  &dcl_node
 )
 {
-        if (state.parsedNode()) {
-                Ptr me = new this_t;
-                if (!me->check(state, CXXParser::getFrom(state),
-                               *state.parsedNode())) {
-                        return false;
-                }
-                state.parsedNode()->setAuxData(me);
+        auto id = dcl_node.find(cxx.grammar().declarator_id);
+
+        if (!id) {
+                return nullptr;
         }
-        return true;
+
+        const Token *first = id->firstToken(),
+                    *name  = id->lastToken();
+
+        if (!name->is(TOK_IDENTIFIER)) {
+                return nullptr;  // operator, destructor or template-id
+        } else if ((first != name) && (!first->is(TOK_ELLIPSIS)
+                                       || (first->next() != name))) {
+                return nullptr;  // qualified-id
+        }
+
+        return name;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::Declarator::check(
-        ParseState     &state,
-        CXXParser      &cxx,
-        const SPPFNode &dcl_node
+static bool
+hasTypedefSpecifier(
+        const CXXParser &cxx,
+        const SPPFNode  &decl_spec_seq
 )
 {
-        SPPFNode::ConstPtr  nested_dcl     = nullptr;
-        const Token        *ref_op         = nullptr;
-        bool                ref_to_ref     = false,
-                            ptr_to_ref     = false,
-                            multi_fn_parms = false,
-                            array_of_refs  = false;
-
-        for (const SPPFNode &part: subProductions(dcl_node)) {
-                if (part.is(cxx.ptr_operator)) {
-                        if (part.firstToken()->is(TOK_AMP)
-                                        || part.firstToken()->is(TOK_AMPAMP)) {
-                                if (!ref_op) {
-                                        ref_op = part.firstToken();
-                                } else if (!ref_to_ref) {
-                                        state.emit(Diagnostic::ERROR,
-                                                   "reference to reference not permitted");
-                                        ref_to_ref = true;
-                                }
-                        } else if (ref_op && !ptr_to_ref) {
-                                state.emit(Diagnostic::ERROR,
-                                           "pointer to reference not permitted");
-                                ptr_to_ref = true;
-                        }
-                        last_ptr = part.firstToken();
-                } else if (part.is(cxx.parameters_and_qualifiers)) {
-                        if (!begin_parms) {
-                                begin_parms = part.firstToken();
-                                        /* = first token of
-                                             parameter-declaration-clause */
-                        } else if (!multi_fn_parms) {
-                                state.emit(Diagnostic::ERROR, part,
-                                           "multiple sets of function parameters/qualifiers");
-                                multi_fn_parms = true;
-                        }
-                } else if (part.is(cxx.array_declarator)) {
-                        if (ref_op && !array_of_refs) {
-                                state.emit(Diagnostic::ERROR,
-                                           "array of references not permitted");
-                                array_of_refs = true;
+        for (const SPPFNode &spec: nonTerminals(decl_spec_seq)) {
+                if (spec.is(cxx.grammar().decl_specifier)) {
+                        if (spec.firstToken()->is(TOK_KW_TYPEDEF)) {
+                                return true;
                         }
-                        array = true;
-                } else if (part.is(cxx.nested_declarator)
-                                || part.is(cxx.nested_abstract_declarator)) {
-                        nested_dcl = &part;
+                } else if (spec.is(cxx.grammar().decl_specifier_seq)
+                                && hasTypedefSpecifier(cxx, spec)) {
+                        return true;
                 }
         }
 
-        if (nested_dcl) {
-                return check(state, cxx, *nested_dcl);
-        }
-
-        return true;
+        return false;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::Declarator::isFunction(
-        ParseState &state  ///< the current parsing state
+static void
+declare(
+        SymbolTable &symbols,
+        const Token *name,
+        uint8_t      kind
 )
 {
-        auto               &cxx      = CXXParser::getFrom(state);
-        SPPFNode::ConstPtr  dcl_node = state.parsedNode();
-        return dcl_node
-                && (dcl_node->find(cxx.parameters_and_qualifiers) != nullptr);
+        if (name) {
+                symbols.declare(name->spelling(), kind, name->offset());
+        }
 }
 
 //--------------------------------------
 
-WRPARSECXX_API bool
-CXXParser::DeclaratorPart::isParmPackOperator(
+static void
+declareDeclarators(
         CXXParser      &cxx,
-        const SPPFNode &part
+        const SPPFNode &node,
+        uint8_t         kind
 )
 {
-        return (part.is(cxx.declarator_id)
-                                && part.firstToken()->is(TOK_ELLIPSIS))
-               || part.is(cxx.abstract_pack_declarator);
+        auto &gram = cxx.grammar();
+
+        for (const SPPFNode &part: nonTerminals(node)) {
+                if (part.is(gram.declarator)) {
+                        declare(cxx.symbols(), declaratorName(cxx, part),
+                                kind);
+                } else if (part.is(gram.init_declarator_list)
+                                || part.is(gram.init_declarator)
+                                || part.is(gram.member_declarator_list)
+                                || part.is(gram.member_declarator)) {
+                        declareDeclarators(cxx, part, kind);
+                }
+        }
 }
 
 //--------------------------------------
 
-bool
-CXXParser::DeclaratorPart::endParametersAndQualifiers(
-        ParseState &state  ///< the current parsing state
+/*
+ * find the name declared by the declaration following a template header
+ */
+static const Token *
+templatedName(
+        const CXXParser &cxx,
+        const SPPFNode  &decl
 )
 {
-        SPPFNode::ConstPtr result = state.parsedNode();
+        auto &gram = cxx.grammar();
 
-        if (!result) {
-                return false;
-        }
+        SPPFNode::ConstPtr node = &decl;
 
-        Ptr                 me    = new this_t;
-        const CXXParser    &cxx   = CXXParser::getFrom(state);
-        SPPFNode::ConstPtr  parms = nonTerminals(result).node();
+        while (node && (node->is(gram.declaration)
+                        || node->is(gram.block_declaration)
+                        || node->is(gram.member_declaration))) {
+                node = nonTerminals(node).node();
+        }
 
-        if (parms && parms->is(cxx.parameter_declaration_clause)) {
-                if (parms->empty()) {
-                        me->count = 0;
-                } else if (!parms->hasChildren()) {
-                        me->count = 1;
-                } else {
-                        me->count = numeric_cast<unsigned short>(
-                                                      countNonTerminals(parms));
-                }
-                me->variadic = !parms->empty()
-                                && parms->lastToken()->is(TOK_ELLIPSIS);
+        if (!node) {
+                return nullptr;
+        } else if (node->is(gram.alias_declaration)) {
+                return identifierToken(node->find(gram.identifier, 1).get());
+        } else if (node->is(gram.function_definition)) {
+                auto dcl = node->find(gram.declarator, 1);
+                return dcl ? declaratorName(cxx, *dcl) : nullptr;
+        } else if (!node->is(gram.simple_declaration)) {
+                return nullptr;
         }
 
-        for (const SPPFNode &quals: nonTerminals(result)) {
-                if (quals.is(cxx.type_qualifier_seq)) {
-                        me->qualifiers |= typeQualifiersFromSeq(quals);
-                } else if (quals.is(cxx.ref_qualifier)) {
-                        me->qualifiers
-                                |= qualifierForToken(*quals.firstToken());
-                }
+        if (auto list = node->find(gram.init_declarator_list, 1)) {
+                auto dcl = list->find(gram.declarator);
+                return dcl ? declaratorName(cxx, *dcl) : nullptr;
+        } else if (auto head = node->find(gram.class_head_name)) {
+                return identifierToken(head.get());
+        } else if (auto elab = node->find(gram.elaborated_type_specifier)) {
+                const Token *name = elab->lastToken();
+                return name->is(TOK_IDENTIFIER) ? name : nullptr;
         }
 
-        result->setAuxData(me);
-        return true;
+        return nullptr;
 }
 
 //--------------------------------------
 
+/*
+ * callback for simple-declaration, member-declaration and
+ * function-definition
+ */
 bool
-CXXParser::DeclaratorPart::endPtrOperator(
+CXXParser::declareNames(
         ParseState &state  ///< the current parsing state
 )
 {
-        SPPFNode::ConstPtr result = state.parsedNode();
-
-        if (!result) {  // didn't match
-                return false;
-        }
-
-        Ptr              me         = new this_t;
-        const CXXParser &cxx        = CXXParser::getFrom(state);
-        auto             type_quals = result->find(cxx.type_qualifier_seq, 1);
-
-        if (type_quals) {
-                me->qualifiers = typeQualifiersFromSeq(*type_quals);
+        if (SPPFNode::ConstPtr node = state.parsedNode()) {
+                CXXParser::getFrom(state).enterDeclaredNames(*node);
         }
-
-        result->setAuxData(me);
         return true;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::isTypedefName(
-        ParseState &state
+void
+CXXParser::enterDeclaredNames(
+        const SPPFNode &node
 )
 {
-        (void) state;
-        return false;
+        uint8_t kind = SymbolTable::OBJECT;
+        auto    spec = node.find(grammar().decl_specifier_seq, 1);
+
+        if (spec && hasTypedefSpecifier(*this, *spec)) {
+                kind = SymbolTable::TYPEDEF;
+        }
+
+        declareDeclarators(*this, node, kind);
 }
 
 //--------------------------------------
 
+/*
+ * callback for nonterminals declaring a single name: class-head,
+ * elaborated-type-specifier, enum-head, opaque-enum-declaration, enumerator,
+ * original-namespace-definition, namespace-alias-definition,
+ * alias-declaration and using-declaration
+ */
 bool
-CXXParser::isClassName(
-        ParseState &state
+CXXParser::declareName(
+        ParseState &state  ///< the current parsing state
 )
 {
-        (void) state;
-        return false;
+        if (SPPFNode::ConstPtr node = state.parsedNode()) {
+                CXXParser::getFrom(state).enterDeclaredName(*node);
+        }
+        return true;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::isEnumName(
-        ParseState &state
+void
+CXXParser::enterDeclaredName(
+        const SPPFNode &node
 )
 {
-        (void) state;
-        return false;
+        auto        &gram = grammar();
+        const Token *name = nullptr;
+        uint8_t      kind = 0;
+
+        if (node.is(gram.class_head)) {
+                name = identifierToken(
+                                node.find(gram.class_head_name, 1).get());
+                kind = SymbolTable::CLASS;
+        } else if (node.is(gram.elaborated_type_specifier)) {
+                if (!node.find(gram.nested_name_specifier, 1)) {
+                        name = identifierToken(
+                                        node.find(gram.identifier, 1).get());
+                        kind = node.firstToken()->is(TOK_KW_ENUM) ?
+                                SymbolTable::ENUM : SymbolTable::CLASS;
+                        if (name && lookupName(*name, kind)) {
+                                name = nullptr;  // refers to earlier name
+                        }
+                }
+        } else if (node.is(gram.enum_head)
+                        || node.is(gram.opaque_enum_declaration)) {
+                if (!node.find(gram.nested_name_specifier, 1)) {
+                        name = identifierToken(
+                                        node.find(gram.identifier, 1).get());
+                        kind = SymbolTable::ENUM;
+                }
+        } else if (node.is(gram.enumerator)) {
+                name = identifierToken(&node);
+                kind = SymbolTable::OBJECT;
+        } else if (node.is(gram.original_namespace_definition)) {
+                name = identifierToken(
+                                node.find(gram.undeclared_name, 1).get());
+                kind = SymbolTable::NAMESPACE;
+        } else if (node.is(gram.namespace_alias_definition)) {
+                name = identifierToken(node.find(gram.identifier, 1).get());
+                kind = SymbolTable::NAMESPACE_ALIAS;
+        } else if (node.is(gram.alias_declaration)) {
+                name = identifierToken(node.find(gram.identifier, 1).get());
+                kind = SymbolTable::TYPEDEF;
+        } else if (node.is(gram.using_declaration)) {
+                name = identifierToken(node.find(gram.unqualified_id, 1).get());
+                if (name) {  // redeclares whatever name refers to
+                        auto sym = lookupName(*name, SymbolTable::ANY);
+                        kind = sym ? (sym->kind
+                                      & ~SymbolTable::TEMPLATE_PARAMETER) : 0;
+                }
+        }
+
+        if (kind) {
+                declare(symbols_, name, kind);
+        }
 }
 
 //--------------------------------------
 
 bool
-CXXParser::isNamespaceName(
-        ParseState &state
+CXXParser::declareTemplateParameter(
+        ParseState &state  ///< the current parsing state
 )
 {
-        (void) state;
-        return false;
+        if (SPPFNode::ConstPtr node = state.parsedNode()) {
+                CXXParser::getFrom(state).enterTemplateParameter(*node);
+        }
+        return true;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::isNamespaceAliasName(
-        ParseState &state
+void
+CXXParser::enterTemplateParameter(
+        const SPPFNode &node
 )
 {
-        (void) state;
-        return false;
+        auto &gram = grammar();
+        auto  parm = nonTerminals(node).node();
+
+        if (!parm) {
+                return;
+        } else if (parm->is(gram.type_parameter)) {
+                uint8_t kind = parm->firstToken()->is(TOK_KW_TEMPLATE) ?
+                                        SymbolTable::TEMPLATE :
+                                        SymbolTable::TYPEDEF;
+                declare(symbols_,
+                        identifierToken(parm->find(gram.identifier, 1).get()),
+                        kind | SymbolTable::TEMPLATE_PARAMETER);
+        } else if (auto dcl = parm->find(gram.declarator, 1)) {
+                declare(symbols_, declaratorName(*this, *dcl),
+                        SymbolTable::OBJECT | SymbolTable::TEMPLATE_PARAMETER);
+        }
 }
 
 //--------------------------------------
 
+/*
+ * callback for class-specifier, enum-specifier, compound-statement and
+ * template-declaration; ends the scope of names declared within
+ */
 bool
-CXXParser::isTemplateName(
-        ParseState &state
+CXXParser::endScope(
+        ParseState &state  ///< the current parsing state
 )
 {
-        (void) state;
-        return false;
+        if (SPPFNode::ConstPtr node = state.parsedNode()) {
+                CXXParser::getFrom(state).closeScopeOf(*node);
+        }
+        return true;
 }
 
 //--------------------------------------
 
-bool
-CXXParser::isUndeclaredName(
-        ParseState &state
+void
+CXXParser::closeScopeOf(
+        const SPPFNode &node
 )
 {
-        (void) state;
-        return true;
+        if (node.empty()) {
+                return;
+        }
+
+        auto   &gram = grammar();
+        size_t  end  = node.lastToken()->offset();
+
+        if (node.is(gram.class_specifier)) {
+                auto head = node.find(gram.class_head, 1);
+                if (head && !head->empty()) {
+                        /* C: nested struct/union/enum tags remain visible
+                           outside the enclosing struct or union */
+                        symbols_.closeScope(head->lastToken()->offset(), end,
+                                            langCXX() ? SymbolTable::ANY :
+                                                        SymbolTable::OBJECT);
+                }
+        } else if (node.is(gram.enum_specifier)) {
+                auto head = node.find(gram.enum_head, 1);
+                auto key  = head ? head->find(gram.enum_key, 1) : nullptr;
+                if (key && (key->firstToken() != key->lastToken())) {
+                        // scoped enumeration: enumerators not visible outside
+                        symbols_.closeScope(head->lastToken()->offset(),
+                                            end);
+                }
+        } else if (node.is(gram.compound_statement)) {
+                symbols_.closeScope(node.firstToken()->offset(), end);
+        } else if (node.is(gram.template_declaration)) {
+                symbols_.closeScope(node.firstToken()->offset(), end,
+                                    SymbolTable::TEMPLATE_PARAMETER);
+                if (auto decl = node.find(gram.declaration, 1)) {
+                        declare(symbols_, templatedName(*this, *decl),
+                                SymbolTable::TEMPLATE);
+                }
+        }
 }
 
 //--------------------------------------
 
-bool
-CXXParser::isFinalSpecifier(
-        ParseState &state  ///< the current parsing state
+/*
+ * Re-enter the names declared within root, visiting its nodes (including
+ * every alternative of ambiguous nodes) as the parser completed them:
+ * children before their parents, in source order
+ */
+void
+CXXParser::redeclare(
+        const SPPFNode &root
 )
 {
-        return *state.input() == u8"final";
+        auto &gram = grammar();
+
+        std::vector<std::pair<const SPPFNode *, bool>> pending { { &root,
+                                                                   false } };
+        std::unordered_set<const SPPFNode *>           seen    { &root };
+        std::vector<const SPPFNode *>                  children;
+
+        while (!pending.empty()) {
+                const SPPFNode &node = *pending.back().first;
+
+                if (!pending.back().second) {
+                        pending.back().second = true;
+                        children.clear();
+
+                        for (const SPPFNode &child: node) {
+                                if (seen.insert(&child).second) {
+                                        children.push_back(&child);
+                                }
+                        }
+
+                        for (auto i = children.rbegin();
+                                        i != children.rend(); ++i) {
+                                pending.emplace_back(*i, false);
+                        }
+                        continue;
+                }
+
+                pending.pop_back();
+
+                if (!node.isNonTerminal()) {
+                        continue;
+                } else if (node.is(gram.simple_declaration)
+                                || node.is(gram.member_declaration)
+                                || node.is(gram.function_definition)) {
+                        enterDeclaredNames(node);
+                } else if (node.is(gram.template_parameter)) {
+                        enterTemplateParameter(node);
+                } else {
+                        enterDeclaredName(node);
+                        closeScopeOf(node);
+                }
+        }
 }
 
 //--------------------------------------
 
+/*
+ * reject primary-expressions consisting of a lone type name
+ */
 bool
-CXXParser::isBalancedToken(
+CXXParser::checkPrimaryExpression(
         ParseState &state  ///< the current parsing state
 )
 {
-        switch (state.input()->kind()) {
-        case TOK_LPAREN: case TOK_RPAREN: case TOK_LSQUARE: case TOK_RSQUARE:
-        case TOK_LBRACE: case TOK_RBRACE:
-                return false;
-        default:
+        SPPFNode::ConstPtr node = state.parsedNode();
+
+        if (!node) {
                 return true;
         }
+
+        auto        &cxx  = CXXParser::getFrom(state);
+        const Token *name = identifierToken(node.get());
+
+        if (!name) {
+                return true;
+        }
+
+        auto sym = cxx.lookupName(*name, cxx.langCXX() ?
+                                        uint8_t(SymbolTable::ANY) : C_ORDINARY);
+
+        return !sym || (sym->kind & SymbolTable::OBJECT)
+                    || !(sym->kind & (SymbolTable::TYPEDEF
+                                      | SymbolTable::CLASS
+                                      | SymbolTable::ENUM));
 }
 
 //--------------------------------------
-
+/**
+ * \brief FIRST_SET_LOOKAHEAD mode: reject a nonterminal on entry if the
+ *      next token cannot begin any of its rules
+ *
+ * Registered only with nonterminals that cannot derive an empty sequence,
+ * so the parser creates no descriptors for rules bound to fail on their
+ * first token. Statements, declarations and unary expressions, having many
+ * rules each beginning with a distinct keyword or punctuator, gain most.
+ */
 bool
-CXXParser::processTemplParmArgListEndToken(
+CXXParser::checkFirstSet(
         ParseState &state  ///< the current parsing state
 )
 {
-        if (CXXParser::getFrom(state).options_.cxx() < cxx::CXX11) {
-                return true;
-        }
-
-        auto token = state.parser().tokens().make_iterator(state.input());
+        const Token *token = state.input();
 
-        TokenKind   new_kind;
-        const char *new_spelling;
-
-        switch (token->kind()) {
-        case TOK_GREATER:
+        if (!token) {
                 return true;
-        case TOK_RSHIFT:
-                new_kind = TOK_GREATER, new_spelling = u8">";
-                break;
-        case TOK_GREATEREQUAL:
-                new_kind = TOK_EQUAL, new_spelling = u8"=";
-                break;
-        case TOK_RSHIFTEQUAL:
-                new_kind = TOK_GREATEREQUAL, new_spelling = u8">=";
-                break;
-        default:
-                return false;
         }
 
-        if (!(token->flags() & cxx::TF_SPLITABLE)) {
-                return false;
-        }
+        const Grammar::FirstSet *first
+                = CXXParser::getFrom(state).grammar().first(
+                                                        state.nonTerminal());
 
-        // split token in two
-        token->setKind(TOK_GREATER).setSpelling(u8">");
-        state.parser().tokens().emplace_after(token, *token)
-                ->setKind(new_kind).setSpelling(new_spelling).adjustOffset(1);
-        return true;
+        return !first || first->admits(*token);
 }
 
 
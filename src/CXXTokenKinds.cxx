@@ -228,6 +228,10 @@ static const std::map<TokenKind, TokenKindInfo> TOKEN_KINDS = {
         { TOK_PP_WARNING, u8"#warning" },
         { TOK_PP_PRAGMA, u8"#pragma" },
         { TOK_PP_NULL, u8"#" },
+        { TOK_SKIPPED_BODY, { u8"skipped_body", u8"{...}" }},
+        { TOK_BALANCED_TOKEN_SEQ, { u8"balanced_token_seq",
+                                    u8"balanced token sequence" }},
+        { TOK_LITERAL_LIST, { u8"literal_list", u8"literal list" }},
 };
 
 //--------------------------------------
@@ -0,0 +1,455 @@
+/**
+ * \file DeclSplitter.cxx
+ *
+ * \brief Splitting of input into top-level declarations
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <algorithm>
+#include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/DeclSplitter.h>
+
+
+namespace wr {
+namespace parse {
+
+
+using namespace cxx;
+
+
+WRPARSECXX_API
+DeclSplitter::DeclSplitter(
+        Lexer &lexer
+) :
+        lexer_(lexer)
+{
+}
+
+//--------------------------------------
+/**
+ * \brief read the lexer's entire input, dividing it into runs
+ *
+ * \return
+ *      number of runs
+ */
+WRPARSECXX_API size_t
+DeclSplitter::split()
+{
+        size_t scopes   = 0,      // enclosing namespace/linkage braces
+               depth    = 0;      // brackets open within current run
+        Close  close    = AT_SEMI;
+        bool   grouping = false;  // within run's first top-level '('
+        Token  t;
+
+        runs_.emplace_back(new TokenRun);
+
+        while (!lexer_.lex(t).is(TOK_EOF)) {
+                if (t.flags() & TF_PREPROCESS) {
+                        runs_.back()->add(t);
+                        continue;
+                } else if (!depth && t.is(TOK_RBRACE) && scopes
+                           && top_.empty()) {
+                        --scopes;  // end of namespace body: drop '}'
+                        continue;
+                }
+
+                if (!depth) {
+                        top_.push_back(t);
+                } else if (grouping && (depth == 1)) {
+                        group_.push_back(t);
+                }
+
+                switch (t.kind()) {
+                case TOK_LBRACE:
+                        if (!depth) {
+                                if (opensScope()) {
+                                        declareNames();
+                                        top_.clear();
+                                        group_.clear();
+                                        runs_.back().reset(new TokenRun);
+                                        ++scopes;
+                                        continue;  // drop scope's head
+                                }
+                                close = braceCloses();
+                        }
+                        ++depth;
+                        break;
+                case TOK_LPAREN: case TOK_LSQUARE:
+                        if (!depth && t.is(TOK_LPAREN) && group_.empty()) {
+                                grouping = true;
+                        }
+                        ++depth;
+                        break;
+                case TOK_RBRACE:
+                        if (depth && !--depth && (close == AT_BRACE)) {
+                                runs_.back()->add(t);
+                                endRun();
+                                close = AT_SEMI;
+                                continue;
+                        }
+                        break;
+                case TOK_RPAREN: case TOK_RSQUARE:
+                        if (depth && !--depth) {
+                                grouping = false;
+                        }
+                        break;
+                case TOK_SEMI:
+                        if (!depth) {
+                                runs_.back()->add(t);
+                                endRun();
+                                close = AT_SEMI;
+                                continue;
+                        }
+                        break;
+                default:
+                        break;
+                }
+
+                runs_.back()->add(t);
+        }
+
+        if (runs_.back()->empty()) {
+                runs_.pop_back();
+        } else {
+                declareNames();
+        }
+
+        top_.clear();
+        group_.clear();
+        return runs_.size();
+}
+
+//--------------------------------------
+
+void
+DeclSplitter::endRun()
+{
+        declareNames();
+        top_.clear();
+        group_.clear();
+        runs_.emplace_back(new TokenRun);
+}
+
+//--------------------------------------
+
+/*
+ * The name declared by a parenthesized declarator such as (*name),
+ * (&name), (Class::*name) or (*name[N]) forming the run's first top-level
+ * parentheses, or nullptr if those hold something else, such as a
+ * parameter list
+ */
+const Token *
+DeclSplitter::groupDeclaratorId() const
+{
+        bool pointer = false;
+
+        for (size_t i = 0; i + 1 < group_.size(); ++i) {
+                switch (group_[i].kind()) {
+                case TOK_STAR: case TOK_AMP: case TOK_AMPAMP:
+                        pointer = true;
+                        break;
+                case TOK_IDENTIFIER:
+                        if (pointer && (group_[i + 1].is(TOK_RPAREN)
+                                        || group_[i + 1].is(TOK_LSQUARE))) {
+                                return &group_[i];
+                        }
+                        break;
+                case TOK_COLONCOLON: case TOK_KW_CONST: case TOK_KW_VOLATILE:
+                        break;
+                default:
+                        return nullptr;
+                }
+        }
+
+        return nullptr;
+}
+
+//--------------------------------------
+
+/*
+ * determine if the '{' ending top_ opens a namespace body or linkage
+ * specification: "[inline] namespace [name[::name...]] {" or
+ * "extern string-literal {"
+ */
+bool
+DeclSplitter::opensScope() const
+{
+        size_t i = 0, n = top_.size() - 1;  // excluding '{'
+
+        if ((n >= 2) && top_[0].is(TOK_KW_EXTERN)) {
+                for (i = 1; (i < n) && top_[i].is(TOK_STR_LITERAL); ++i) {
+                        ;
+                }
+                return (i > 1) && (i == n);
+        }
+
+        if ((i < n) && top_[i].is(TOK_KW_INLINE)) {
+                ++i;
+        }
+
+        if ((i >= n) || !top_[i].is(TOK_KW_NAMESPACE)) {
+                return false;
+        }
+
+        for (++i; i < n; ++i) {
+                if (!top_[i].is(TOK_IDENTIFIER)
+                    && !top_[i].is(TOK_COLONCOLON)) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+//--------------------------------------
+
+/*
+ * determine whether the top-level '{' ending top_ opens a function body,
+ * after which the declaration ends at the matching '}', or a class or
+ * enumeration body or braced initializer (possibly within an initializer
+ * such as a lambda's), which a ';' must follow
+ */
+DeclSplitter::Close
+DeclSplitter::braceCloses() const
+{
+        size_t n          = top_.size() - 1;  // excluding '{'
+        size_t angle      = 0;  // template argument/parameter list depth
+        bool   have_parms = false,
+               ctor_init  = false;
+
+        if (!n) {
+                return AT_SEMI;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+                switch (top_[i].kind()) {
+                case TOK_KW_CLASS: case TOK_KW_STRUCT: case TOK_KW_UNION:
+                case TOK_KW_ENUM:
+                        if (!have_parms) {
+                                /* class-key name [final] followed by '{' or
+                                   base-clause: class or enum definition */
+                                size_t j = i + 1, angle = 0;
+                                for (; j < n; ++j) {
+                                        TokenKind k = top_[j].kind();
+                                        if (k == TOK_LESS) {
+                                                ++angle;
+                                        } else if (angle && (k == TOK_GREATER)) {
+                                                --angle;
+                                        } else if (!angle
+                                                   && (k != TOK_IDENTIFIER)
+                                                   && (k != TOK_COLONCOLON)
+                                                   && (k != TOK_KW_CLASS)
+                                                   && (k != TOK_KW_STRUCT)
+                                                   && (k != TOK_LSQUARE)
+                                                   && (k != TOK_RSQUARE)) {
+                                                break;
+                                        }
+                                }
+                                if ((j == n) || top_[j].is(TOK_COLON)) {
+                                        return AT_SEMI;
+                                }
+                        }
+                        break;
+                case TOK_LPAREN:
+                        have_parms = true;
+                        break;
+                case TOK_COLON:
+                        ctor_init = have_parms;
+                        break;
+                case TOK_LESS:
+                        if (!i || !top_[i - 1].is(TOK_KW_OPERATOR)) {
+                                ++angle;
+                        }
+                        break;
+                case TOK_GREATER:
+                        if (angle) {
+                                --angle;
+                        }
+                        break;
+                case TOK_RSHIFT:
+                        angle -= std::min<size_t>(angle, 2);
+                        break;
+                case TOK_EQUAL:
+                        /* top_ holds no tokens within parentheses, so
+                           outside any template parameter list this begins
+                           an initializer: = { ... } or = [](...) { ... } */
+                        if (!angle && (!i
+                                       || !top_[i - 1].is(TOK_KW_OPERATOR))) {
+                                return AT_SEMI;
+                        }
+                        break;
+                default:
+                        break;
+                }
+        }
+
+        switch (top_[n - 1].kind()) {
+        case TOK_IDENTIFIER: case TOK_GREATER: case TOK_RSQUARE:
+                if (ctor_init || !have_parms) {
+                        return AT_SEMI;    /* mem-initializer or braced
+                                              initializer */
+                }
+                return AT_BRACE;           /* virt-specifier or trailing
+                                              return type */
+        default:
+                return AT_BRACE;
+        }
+}
+
+//--------------------------------------
+
+/*
+ * Enter names evidently declared by the tokens in top_. This is a
+ * heuristic: it only needs to catch the names whose kind matters to
+ * parsing, chiefly type names.
+ */
+void
+DeclSplitter::declareNames()
+{
+        size_t n        = top_.size();
+        bool   templ    = (n && top_[0].is(TOK_KW_TEMPLATE)),
+               typedefs = false,
+               tagged   = false;
+
+        auto declare = [&](const Token &name, uint8_t kind) {
+                if (templ) {
+                        kind |= SymbolTable::TEMPLATE;
+                }
+                names_.declare(name.spelling(), kind, name.offset());
+        };
+
+        for (size_t i = 0; i < n; ++i) {
+                const Token &t = top_[i];
+                uint8_t      kind;
+
+                switch (t.kind()) {
+                case TOK_KW_TYPEDEF:
+                        typedefs = true;
+                        continue;
+                case TOK_KW_CLASS: case TOK_KW_STRUCT: case TOK_KW_UNION:
+                        kind = SymbolTable::CLASS;
+                        break;
+                case TOK_KW_ENUM:
+                        kind = SymbolTable::ENUM;
+                        break;
+                case TOK_KW_NAMESPACE:
+                        kind = SymbolTable::NAMESPACE;
+                        break;
+                case TOK_KW_USING:
+                        if ((i + 2 < n) && top_[i + 1].is(TOK_IDENTIFIER)
+                                        && top_[i + 2].is(TOK_EQUAL)) {
+                                declare(top_[i + 1], SymbolTable::TYPEDEF);
+                        }
+                        continue;
+                default:
+                        continue;
+                }
+
+                // last identifier of [class|struct] name[::name...]
+                size_t j = i + 1;
+                if ((j < n) && (top_[j].is(TOK_KW_CLASS)
+                                || top_[j].is(TOK_KW_STRUCT))) {
+                        ++j;  // enum class
+                }
+                const Token *name = nullptr;
+                for (; j < n; ++j) {
+                        if (top_[j].is(TOK_IDENTIFIER)) {
+                                name = &top_[j];
+                        } else if (!top_[j].is(TOK_COLONCOLON)) {
+                                break;
+                        }
+                }
+                if (!name) {
+                        continue;
+                }
+                if ((kind == SymbolTable::NAMESPACE) && (j < n)
+                                && top_[j].is(TOK_EQUAL)) {
+                        kind = SymbolTable::NAMESPACE_ALIAS;
+                }
+                if (templ && (j < n) && (top_[j].is(TOK_GREATER)
+                                         || top_[j].is(TOK_COMMA)
+                                         || top_[j].is(TOK_EQUAL))) {
+                        continue;  // template type parameter
+                }
+                if (kind != SymbolTable::NAMESPACE) {
+                        tagged = true;
+                }
+                declare(*name, kind);
+        }
+
+        if (typedefs) {
+                /* typedef ... name [, name...] ; where each name may be
+                   followed by '[' or '(' or be parenthesized, as in
+                   typedef void (*name)(int); */
+                bool first_paren = true;
+
+                for (size_t i = 1; i < n; ++i) {
+                        const Token *name = nullptr;
+
+                        switch (top_[i].kind()) {
+                        case TOK_LPAREN:
+                                name = first_paren ? groupDeclaratorId()
+                                                   : nullptr;
+                                first_paren = false;
+                                if (name) {
+                                        break;
+                                } // else fall through
+                        case TOK_SEMI: case TOK_COMMA: case TOK_LSQUARE:
+                                if (top_[i - 1].is(TOK_IDENTIFIER)) {
+                                        name = &top_[i - 1];
+                                }
+                                break;
+                        default:
+                                break;
+                        }
+
+                        if (name) {
+                                declare(*name, SymbolTable::TYPEDEF);
+                        }
+                }
+        } else if (!tagged) {
+                // first declarator-id of a simple-declaration or function
+                for (size_t i = 1; i < n; ++i) {
+                        const Token *name = nullptr;
+
+                        switch (top_[i].kind()) {
+                        case TOK_LPAREN: case TOK_SEMI: case TOK_COMMA:
+                        case TOK_EQUAL: case TOK_LSQUARE: case TOK_LBRACE:
+                                if (top_[i].is(TOK_LPAREN)) {
+                                        name = groupDeclaratorId();
+                                }
+                                if (!name && top_[i - 1].is(TOK_IDENTIFIER)) {
+                                        name = &top_[i - 1];
+                                }
+                                if (name) {
+                                        declare(*name, SymbolTable::OBJECT);
+                                }
+                                i = n;
+                                break;
+                        default:
+                                break;
+                        }
+                }
+        }
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -26,9 +26,13 @@
 #include <stdint.h>
 #include <limits.h>
 #include <ctype.h>
+#include <math.h>
+#include <string.h>
 #include <iostream>
 #include <string>
+#include <vector>
 
+#include <wrutil/CityHash.h>
 #include <wrutil/u8string_view.h>
 #include <wrparse/SPPF.h>
 #include <wrparse/cxx/CXXLexer.h>
@@ -50,25 +54,39 @@ matchConstExpr(
         ExprType            target_type
 )
 {
-        bool result = false;
+        ConstExprEvaluator evaluator(cxx);
 
-        while (a->is(cxx.paren_expression)) {
-                a = nonTerminals(a).node();
-        }
-        while (b->is(cxx.paren_expression)) {
-                b = nonTerminals(b).node();
-        }
-        if (a->is(cxx.literal)) {
-                Literal a_literal(cxx, *a);
+        return matchConstExpr(evaluator, a, b, target_type);
+}
 
-                if (b->is(cxx.literal)) {
-                        Literal b_literal(cxx, *b);
-                        result = areEquivalent(a_literal, b_literal,
-                                               target_type);
-                }
-        }
+//--------------------------------------
+/**
+ * \brief determine if two constant expressions have the same value
+ *
+ * \param [in] evaluator
+ *      folds \c a and \c b, reusing any results memoized by earlier calls
+ * \param [in] a, b
+ *      expressions to compare
+ * \param [in] target_type
+ *      type both values are converted to before comparison; if unset, their
+ *      best common type
+ * \return
+ *      \c true if both expressions fold to equivalent values, \c false if
+ *      they differ or either cannot be folded
+ */
+WRPARSECXX_API bool
+matchConstExpr(
+        ConstExprEvaluator &evaluator,
+        SPPFNode::ConstPtr  a,
+        SPPFNode::ConstPtr  b,
+        ExprType            target_type
+)
+{
+        Literal a_value, b_value;
 
-        return result;
+        return evaluator.evaluate(*a, a_value)
+                && evaluator.evaluate(*b, b_value)
+                && areEquivalent(a_value, b_value, target_type);
 }
 
 //--------------------------------------
@@ -255,10 +273,12 @@ ExprType::set(
         const SPPFNode &declarator
 )
 {
-        auto decl_specifier_seq = declarator.find(cxx.decl_specifier_seq);
+        auto &gram = cxx.grammar();
+
+        auto decl_specifier_seq = declarator.find(gram.decl_specifier_seq);
 
         if (!decl_specifier_seq) {
-                decl_specifier_seq = declarator.find(cxx.type_specifier_seq);
+                decl_specifier_seq = declarator.find(gram.type_specifier_seq);
                 if (!decl_specifier_seq) {
                         return *this;
                 }
@@ -281,16 +301,18 @@ Literal::Literal(
         const SPPFNode &input
 )
 {
-        if (input.is(cxx.numeric_literal)) {
+        auto &gram = cxx.grammar();
+
+        if (input.is(gram.numeric_literal)) {
                 readNumericLiteral(*input.firstToken());
-        } else if (input.is(cxx.character_literal)) {
+        } else if (input.is(gram.character_literal)) {
                 readCharacterLiteral(*input.firstToken());
-        } else if (input.is(cxx.string_literal)) {
+        } else if (input.is(gram.string_literal)) {
                 ;
-        } else if (input.is(cxx.boolean_literal)) {  // true or false
+        } else if (input.is(gram.boolean_literal)) {  // true or false
                 type.type = ExprType::Type::BOOL;
                 i = input.firstToken()->kind() == TOK_KW_TRUE;
-        } else if (input.is(cxx.pointer_literal)) {  // nullptr
+        } else if (input.is(gram.pointer_literal)) {  // nullptr
                 type.type = ExprType::Type::NULLPTR_T;
                 u = 0;
         } /* else input is either a user-defined literal (can't handle these)
@@ -298,6 +320,31 @@ Literal::Literal(
              such */
 }
 
+//--------------------------------------
+/**
+ * \brief read the value of a lone literal token
+ *
+ * For numeric, character and boolean literal tokens. A numeric literal's
+ * spelling may begin with \c '-'. The type is left unset for any other
+ * token.
+ */
+WRPARSECXX_API
+Literal::Literal(
+        const Token &input
+) :
+        Literal()
+{
+        if (input.is(TOK_KW_TRUE) || input.is(TOK_KW_FALSE)) {
+                type.type = ExprType::Type::BOOL;
+                i = input.is(TOK_KW_TRUE);
+        } else {
+                readNumericLiteral(input);
+                if (!type) {
+                        readCharacterLiteral(input);
+                }
+        }
+}
+
 //--------------------------------------
 
 WRPARSECXX_API
@@ -916,6 +963,1055 @@ areEquivalent(
         }
 }
 
+//--------------------------------------
+
+static bool
+isIntegral(
+        const ExprType &type
+)
+{
+        return (type.type >= ExprType::Type::BOOL)
+                && (type.type <= ExprType::Type::INT);
+}
+
+//--------------------------------------
+
+static bool
+isFloating(
+        const ExprType &type
+)
+{
+        return (type.type == ExprType::Type::FLOAT)
+                || (type.type == ExprType::Type::DOUBLE);
+}
+
+//--------------------------------------
+
+static size_t
+byteSize(
+        const ExprType &type
+)
+{
+        switch (type.type) {
+        case ExprType::Type::BOOL:
+                return sizeof(bool);
+        case ExprType::Type::CHAR:
+                return sizeof(char);
+        case ExprType::Type::CHAR16_T:
+                return sizeof(char16_t);
+        case ExprType::Type::CHAR32_T:
+                return sizeof(char32_t);
+        case ExprType::Type::WCHAR_T:
+                return sizeof(wchar_t);
+        case ExprType::Type::INT:
+                switch (type.size) {
+                case ExprType::Size::SHORT:
+                        return sizeof(short);
+                case ExprType::Size::LONG:
+                        return sizeof(long);
+                case ExprType::Size::LONG_LONG:
+                        return sizeof(long long);
+                default:
+                        return sizeof(int);
+                }
+        case ExprType::Type::FLOAT:
+                return sizeof(float);
+        case ExprType::Type::DOUBLE:
+                return (type.size == ExprType::Size::LONG) ?
+                        sizeof(long double) : sizeof(double);
+        default:
+                return 0;
+        }
+}
+
+//--------------------------------------
+/*
+ * Spell types the same way however they were written: "unsigned" and
+ * "short" alone are ints, and an int is explicitly signed unless unsigned
+ */
+static ExprType
+canonical(
+        ExprType type
+)
+{
+        if (!type && (type.sign || type.size)) {
+                type.type = ExprType::Type::INT;
+        }
+        if ((type.type == ExprType::Type::INT)
+                        && (type.sign != ExprType::Sign::UNSIGNED)) {
+                type.sign = ExprType::Sign::SIGNED;
+        }
+        return type;
+}
+
+//--------------------------------------
+/*
+ * Type of an integral operand after integral promotion
+ */
+static ExprType
+promoted(
+        const ExprType &type
+)
+{
+        int rank = type.intConvRank();
+
+        if (!isIntegral(type) || (rank < 0)) {
+                return canonical(type);
+        } else if (rank < 3) {  // represented by int
+                return ExprType(ExprType::Sign::SIGNED,
+                                ExprType::Size::NO_SIZE, ExprType::Type::INT);
+        }
+
+        return ExprType(type.isUnsigned() ? ExprType::Sign::UNSIGNED
+                                          : ExprType::Sign::SIGNED,
+                        (rank == 3) ? ExprType::Size::NO_SIZE
+                                    : (rank == 4) ? ExprType::Size::LONG
+                                                  : ExprType::Size::LONG_LONG,
+                        ExprType::Type::INT);
+}
+
+//--------------------------------------
+/*
+ * Common type of the operands of a binary operator after the usual
+ * arithmetic conversions; unset if either operand is not arithmetic
+ */
+static ExprType
+arithmeticType(
+        const ExprType &a,
+        const ExprType &b
+)
+{
+        if (!a.isNonPtrArithmeticType() || !b.isNonPtrArithmeticType()) {
+                return {};
+        }
+
+        if (isFloating(a) || isFloating(b)) {
+                auto float_rank = [](const ExprType &type) {
+                        return !isFloating(type) ? 0 :
+                               (type.type == ExprType::Type::FLOAT) ? 1 :
+                               (type.size == ExprType::Size::LONG) ? 3 : 2;
+                };
+                return (float_rank(a) >= float_rank(b)) ? a : b;
+        }
+
+        ExprType pa = promoted(a), pb = promoted(b);
+
+        if (pa == pb) {
+                return pa;
+        } else if (pa.isUnsigned() == pb.isUnsigned()) {
+                return (pa.intConvRank() >= pb.intConvRank()) ? pa : pb;
+        }
+
+        const ExprType &u = pa.isUnsigned() ? pa : pb,
+                       &s = pa.isUnsigned() ? pb : pa;
+
+        if (u.intConvRank() >= s.intConvRank()) {
+                return u;
+        } else if (byteSize(s) > byteSize(u)) {
+                return s;  // represents every value of u
+        }
+
+        return ExprType(ExprType::Sign::UNSIGNED, s.size, ExprType::Type::INT);
+}
+
+//--------------------------------------
+/*
+ * Reduce a value to the range and precision of its type
+ */
+static Literal &
+normalize(
+        Literal &value
+)
+{
+        const ExprType &type = value.type;
+
+        switch (type.type) {
+        case ExprType::Type::BOOL:
+                value.i = (value.u != 0);
+                return value;
+        case ExprType::Type::FLOAT:
+                value.d = static_cast<float>(value.d);
+                return value;
+        case ExprType::Type::DOUBLE:
+                if (type.size != ExprType::Size::LONG) {
+                        value.d = static_cast<double>(value.d);
+                }
+                return value;
+        default:
+                break;
+        }
+
+        size_t bits = byteSize(type) * CHAR_BIT;
+
+        if (bits && (bits < (sizeof(uintmax_t) * CHAR_BIT))) {
+                uintmax_t mask = (uintmax_t(1) << bits) - 1;
+
+                value.u &= mask;
+
+                if (type.isSigned() && (value.u >> (bits - 1))) {
+                        value.u |= ~mask;  // sign-extend
+                }
+        }
+
+        return value;
+}
+
+//--------------------------------------
+
+static bool
+convert(
+        Literal  &value,
+        ExprType  to_type
+)
+{
+        if (!to_type || !value.type.isNonPtrArithmeticType()) {
+                return false;
+        } else if (!value.convertType(to_type).type) {
+                return false;
+        }
+
+        normalize(value);
+        return true;
+}
+
+//--------------------------------------
+
+static bool
+truthValue(
+        const Literal &value
+)
+{
+        return isFloating(value.type) ? (value.d != 0) : (value.u != 0);
+}
+
+//--------------------------------------
+
+static bool
+isScalar(
+        const Literal &value
+)
+{
+        return value.type.isNonPtrArithmeticType()
+                || (value.type.type == ExprType::Type::NULLPTR_T);
+}
+
+//--------------------------------------
+/*
+ * Result of a relational, equality, logical or ! operator: bool in C++, int
+ * in C
+ */
+static Literal
+boolResult(
+        CXXParser &cxx,
+        bool       result
+)
+{
+        Literal value;
+
+        if (cxx.langCXX()) {
+                value.type.type = ExprType::Type::BOOL;
+        } else {
+                value.type = ExprType(ExprType::Sign::SIGNED,
+                                      ExprType::Size::NO_SIZE,
+                                      ExprType::Type::INT);
+        }
+        value.i = result;
+        return value;
+}
+
+//--------------------------------------
+/*
+ * Type named by the simple-type-specifier of a function-style cast such as
+ * "unsigned(x)"; unset if not an arithmetic type
+ */
+static ExprType
+simpleType(
+        const SPPFNode &simple_type_specifier
+)
+{
+        ExprType type;
+
+        for (const Token *t = simple_type_specifier.firstToken(); t;
+                                                          t = t->next()) {
+                switch (t->kind()) {
+                case TOK_KW_BOOL:
+                        type.type = ExprType::Type::BOOL;
+                        break;
+                case TOK_KW_CHAR:
+                        type.type = ExprType::Type::CHAR;
+                        break;
+                case TOK_KW_CHAR16_T:
+                        type.type = ExprType::Type::CHAR16_T;
+                        break;
+                case TOK_KW_CHAR32_T:
+                        type.type = ExprType::Type::CHAR32_T;
+                        break;
+                case TOK_KW_WCHAR_T:
+                        type.type = ExprType::Type::WCHAR_T;
+                        break;
+                case TOK_KW_INT:
+                        type.type = ExprType::Type::INT;
+                        break;
+                case TOK_KW_FLOAT:
+                        type.type = ExprType::Type::FLOAT;
+                        break;
+                case TOK_KW_DOUBLE:
+                        type.type = ExprType::Type::DOUBLE;
+                        break;
+                case TOK_KW_SIGNED:
+                        type.sign = ExprType::Sign::SIGNED;
+                        break;
+                case TOK_KW_UNSIGNED:
+                        type.sign = ExprType::Sign::UNSIGNED;
+                        break;
+                case TOK_KW_SHORT:
+                        type.size = ExprType::Size::SHORT;
+                        break;
+                case TOK_KW_LONG:
+                        type.size = type.size ? ExprType::Size::LONG_LONG
+                                              : ExprType::Size::LONG;
+                        break;
+                default:
+                        return {};
+                }
+
+                if (t == simple_type_specifier.lastToken()) {
+                        break;
+                }
+        }
+
+        type = canonical(type);
+        return type.isNonPtrArithmeticType() ? type : ExprType();
+}
+
+//--------------------------------------
+/*
+ * The only initializer-clause of an expression-list or braced-init-list,
+ * or nullptr if it has none or several
+ */
+static const SPPFNode *
+soleInitializer(
+        CXXParser      &cxx,
+        const SPPFNode &list
+)
+{
+        auto &gram      = cxx.grammar();
+        auto  init_list = list.find(gram.initializer_list, 1);
+
+        if (!init_list) {
+                return nullptr;
+        }
+
+        const SPPFNode *clause = nullptr;
+
+        for (const SPPFNode &part: subProductions(*init_list)) {
+                if (part.is(gram.initializer_clause) && !clause) {
+                        clause = &part;
+                } else if (!part.empty()) {  // ',', designation or '...'
+                        return nullptr;
+                }
+        }
+
+        return clause;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API
+ConstExprEvaluator::ConstExprEvaluator(
+        CXXParser &cxx
+) :
+        cxx_(cxx)
+{
+}
+
+//--------------------------------------
+/**
+ * \brief fold an expression to a constant
+ *
+ * \param [in] expr
+ *      any expression nonterminal, or a \c constant_expression or
+ *      \c initializer_clause wrapping one
+ * \param [out] value
+ *      folded value and its type; the type is left unset if \c expr cannot
+ *      be folded
+ * \return
+ *      \c true if \c expr was folded, \c false otherwise
+ */
+WRPARSECXX_API bool
+ConstExprEvaluator::evaluate(
+        const SPPFNode &expr,
+        Literal        &value
+)
+{
+        auto i = memo_.find(&expr);
+
+        if (i == memo_.end()) {
+                Literal result;
+
+                if (!fold(expr, result)) {
+                        result.type = {};
+                }
+
+                i = memo_.emplace(&expr, result).first;
+        }
+
+        value = i->second;
+        return static_cast<bool>(value.type);
+}
+
+//--------------------------------------
+/**
+ * \brief forget all memoized results
+ */
+WRPARSECXX_API ConstExprEvaluator &
+ConstExprEvaluator::clear()
+{
+        memo_.clear();
+        return *this;
+}
+
+//--------------------------------------
+
+bool
+ConstExprEvaluator::fold(
+        const SPPFNode &expr,
+        Literal        &value
+)
+{
+        auto &gram = cxx_.grammar();
+
+        if (expr.is(gram.numeric_literal) || expr.is(gram.character_literal)
+                                          || expr.is(gram.boolean_literal)) {
+                value = Literal(cxx_, expr);
+                return static_cast<bool>(value.type);
+        } else if (expr.isTerminal()) {
+                return false;
+        }
+
+        Parts parts;
+
+        for (const SPPFNode &part: subProductions(expr)) {
+                if (!part.empty()) {
+                        parts.push_back(&part);
+                }
+        }
+
+        if (parts.size() == 1) {  // literal, constant_expression etc.
+                return !parts[0]->isTerminal() && evaluate(*parts[0], value);
+        } else if (parts.empty()) {
+                return false;
+        }
+
+        if (expr.is(gram.paren_expression)) {
+                return (parts.size() == 3) && evaluate(*parts[1], value);
+        } else if (expr.is(gram.unary_expression)) {
+                return foldUnary(parts, value);
+        } else if (expr.is(gram.cast_expression)
+                   || expr.is(gram.postfix_expression)) {
+                return foldCast(parts, value);
+        } else if (expr.is(gram.conditional_expression)) {
+                return foldConditional(parts, value);
+        } else if (expr.is(gram.expression)) {  // comma operator
+                Literal discarded;
+                return (parts.size() == 3) && parts[1]->is(TOK_COMMA)
+                        && evaluate(*parts[0], discarded)
+                        && evaluate(*parts[2], value);
+        } else if ((parts.size() == 3) && parts[1]->isTerminal()) {
+                return foldBinary(expr, parts, value);
+        }
+
+        return false;
+}
+
+//--------------------------------------
+
+bool
+ConstExprEvaluator::foldUnary(
+        const Parts &parts,
+        Literal     &value
+)
+{
+        if (parts[0]->is(TOK_KW_SIZEOF)) {
+                return foldSizeof(parts, value);
+        } else if (!parts[0]->is(cxx_.grammar().unary_operator)
+                        || !evaluate(*parts[1], value)) {
+                return false;  // also ++ and --, never constant
+        }
+
+        switch (parts[0]->firstToken()->kind()) {
+        case TOK_EXCLAIM:
+                if (!isScalar(value)) {
+                        return false;
+                }
+                value = boolResult(cxx_, !truthValue(value));
+                return true;
+        case TOK_PLUS:
+                return convert(value, promoted(value.type));
+        case TOK_MINUS:
+                if (!convert(value, promoted(value.type))) {
+                        return false;
+                } else if (isFloating(value.type)) {
+                        value.d = -value.d;
+                } else {
+                        value.u = 0 - value.u;
+                }
+                break;
+        case TOK_TILDE:
+                if (!isIntegral(value.type)
+                                || !convert(value, promoted(value.type))) {
+                        return false;
+                }
+                value.u = ~value.u;
+                break;
+        default:  // '*' and '&'
+                return false;
+        }
+
+        normalize(value);
+        return true;
+}
+
+//--------------------------------------
+/*
+ * sizeof(T) for arithmetic T, or sizeof applied to a foldable expression
+ */
+bool
+ConstExprEvaluator::foldSizeof(
+        const Parts &parts,
+        Literal     &value
+)
+{
+        ExprType type;
+
+        if (parts.size() == 2) {
+                Literal operand;
+                if (evaluate(*parts[1], operand)
+                                && operand.type.isNonPtrArithmeticType()) {
+                        type = operand.type;
+                }
+        } else if ((parts.size() == 4)
+                   && parts[2]->is(cxx_.grammar().type_id)) {
+                type = typeOf(*parts[2]);
+        }
+
+        if (!type) {
+                return false;
+        }
+
+        value = Literal();
+        value.type = ExprType(ExprType::Sign::UNSIGNED,
+                              (sizeof(size_t) == sizeof(long)) ?
+                                      ExprType::Size::LONG
+                                    : ExprType::Size::LONG_LONG,
+                              ExprType::Type::INT);
+        value.u = byteSize(type);
+        return true;
+}
+
+//--------------------------------------
+/*
+ * "(T) x", "static_cast<T>(x)", "T(x)", "T()" and "T{x}" for arithmetic T
+ */
+bool
+ConstExprEvaluator::foldCast(
+        const Parts &parts,
+        Literal     &value
+)
+{
+        auto           &gram    = cxx_.grammar();
+        ExprType        type;
+        const SPPFNode *operand = nullptr;
+
+        if (parts[0]->is(TOK_LPAREN)) {
+                if ((parts.size() == 4) && parts[1]->is(gram.type_id)) {
+                        type = typeOf(*parts[1]);
+                        operand = parts[3];
+                }
+        } else if (parts[0]->is(TOK_KW_STATIC_CAST)) {
+                if (parts.size() == 7) {
+                        type = typeOf(*parts[2]);
+                        operand = parts[5];
+                }
+        } else if (parts[0]->is(gram.simple_type_specifier)) {
+                type = simpleType(*parts[0]);
+                if ((parts.size() == 3) && parts[2]->is(TOK_RPAREN)) {
+                        value = Literal();  // value-initialized
+                        value.type = type;
+                        if (isFloating(type)) {
+                                value.d = 0;
+                        }
+                        return static_cast<bool>(type);
+                } else if (parts.size() == 4) {
+                        operand = soleInitializer(cxx_, *parts[2]);
+                } else if (parts.size() == 2) {
+                        operand = soleInitializer(cxx_, *parts[1]);
+                }
+        }
+
+        return type && operand && evaluate(*operand, value)
+                    && convert(value, type);
+}
+
+//--------------------------------------
+
+bool
+ConstExprEvaluator::foldBinary(
+        const SPPFNode &expr,
+        const Parts    &parts,
+        Literal        &value
+)
+{
+        auto       &gram = cxx_.grammar();
+        const Rule *rule = expr.rule();
+        auto        op   = parts[1]->firstToken()->kind();
+        Literal     lhs, rhs;
+
+        if (!evaluate(*parts[0], lhs)) {
+                return false;
+        }
+
+        if ((op == TOK_AMPAMP) || (op == TOK_PIPEPIPE)) {
+                bool decided = (op == TOK_PIPEPIPE);  // result if lhs decides
+
+                if (!isScalar(lhs)) {
+                        return false;
+                } else if (truthValue(lhs) != decided) {
+                        // right operand need not be constant otherwise
+                        if (!evaluate(*parts[2], rhs) || !isScalar(rhs)) {
+                                return false;
+                        }
+                        decided = truthValue(rhs);
+                }
+
+                value = boolResult(cxx_, decided);
+                return true;
+        }
+
+        if (!evaluate(*parts[2], rhs)) {
+                return false;
+        }
+
+        if ((rule == gram.left_shift) || (rule == gram.right_shift)) {
+                if (!isIntegral(lhs.type) || !isIntegral(rhs.type)
+                                || !convert(lhs, promoted(lhs.type))
+                                || !convert(rhs, promoted(rhs.type))) {
+                        return false;
+                }
+
+                uintmax_t count = rhs.u;
+
+                if ((rhs.type.isSigned() && (rhs.i < 0))
+                                || (count >= (byteSize(lhs.type) * CHAR_BIT))) {
+                        return false;
+                }
+
+                value = lhs;
+
+                if (rule == gram.left_shift) {
+                        value.u <<= count;
+                } else if (lhs.type.isSigned()) {
+                        value.i >>= count;
+                } else {
+                        value.u >>= count;
+                }
+
+                normalize(value);
+                return true;
+        }
+
+        ExprType type = arithmeticType(lhs.type, rhs.type);
+
+        if (!convert(lhs, type) || !convert(rhs, type)) {
+                return false;
+        }
+
+        bool floating  = isFloating(type),
+             is_signed = type.isSigned();
+        int  order     = floating  ? (lhs.d > rhs.d) - (lhs.d < rhs.d)
+                       : is_signed ? (lhs.i > rhs.i) - (lhs.i < rhs.i)
+                                   : (lhs.u > rhs.u) - (lhs.u < rhs.u);
+
+        if (rule == gram.less) {
+                value = boolResult(cxx_, order < 0);
+        } else if (rule == gram.less_or_equal) {
+                value = boolResult(cxx_, order <= 0);
+        } else if (rule == gram.greater) {
+                value = boolResult(cxx_, order > 0);
+        } else if (rule == gram.greater_or_equal) {
+                value = boolResult(cxx_, order >= 0);
+        } else if (rule == gram.equal) {
+                value = boolResult(cxx_, order == 0);
+        } else if (rule == gram.not_equal) {
+                value = boolResult(cxx_, order != 0);
+        } else if (floating) {
+                value = lhs;
+
+                if (rule == gram.binary_add) {
+                        value.d = lhs.d + rhs.d;
+                } else if (rule == gram.binary_subtract) {
+                        value.d = lhs.d - rhs.d;
+                } else if (rule == gram.multiply) {
+                        value.d = lhs.d * rhs.d;
+                } else if ((rule == gram.divide) && (rhs.d != 0)) {
+                        value.d = lhs.d / rhs.d;
+                } else {  // '%', bitwise operators or division by zero
+                        return false;
+                }
+
+                normalize(value);
+        } else {
+                value = lhs;
+
+                if (rule == gram.binary_add) {
+                        value.u = lhs.u + rhs.u;
+                } else if (rule == gram.binary_subtract) {
+                        value.u = lhs.u - rhs.u;
+                } else if (rule == gram.multiply) {
+                        value.u = lhs.u * rhs.u;
+                } else if ((rule == gram.divide) || (rule == gram.modulo)) {
+                        bool divide = (rule == gram.divide);
+
+                        if (rhs.u == 0) {
+                                return false;
+                        } else if (!is_signed) {
+                                value.u = divide ? (lhs.u / rhs.u)
+                                                 : (lhs.u % rhs.u);
+                        } else if (rhs.i == -1) {  // avoid INTMAX_MIN / -1
+                                value.u = divide ? (0 - lhs.u) : 0;
+                        } else {
+                                value.i = divide ? (lhs.i / rhs.i)
+                                                 : (lhs.i % rhs.i);
+                        }
+                } else if (op == TOK_AMP) {
+                        value.u = lhs.u & rhs.u;
+                } else if (op == TOK_CARET) {
+                        value.u = lhs.u ^ rhs.u;
+                } else if (op == TOK_PIPE) {
+                        value.u = lhs.u | rhs.u;
+                } else {
+                        return false;
+                }
+
+                normalize(value);
+        }
+
+        return true;
+}
+
+//--------------------------------------
+
+bool
+ConstExprEvaluator::foldConditional(
+        const Parts &parts,
+        Literal     &value
+)
+{
+        Literal condition, other;
+
+        if ((parts.size() != 5) || !evaluate(*parts[0], condition)
+                                || !isScalar(condition)) {
+                return false;
+        }
+
+        bool which = truthValue(condition);
+
+        if (!evaluate(*parts[which ? 2 : 4], value)) {
+                return false;
+        }
+
+        /* the result has the common type of both operands, where the other
+           can be folded too */
+        if (evaluate(*parts[which ? 4 : 2], other)) {
+                ExprType type = arithmeticType(value.type, other.type);
+                if (type) {
+                        convert(value, type);
+                }
+        }
+
+        return true;
+}
+
+//--------------------------------------
+/*
+ * Arithmetic type named by a type-id, or unset for any other type
+ */
+ExprType
+ConstExprEvaluator::typeOf(
+        const SPPFNode &type_id
+)
+{
+        auto &gram = cxx_.grammar();
+
+        if (type_id.find(gram.abstract_declarator, 1)) {
+                return {};  // pointer, reference, array or function
+        }
+
+        ExprType type = canonical(ExprType(cxx_, type_id));
+
+        return type.isNonPtrArithmeticType() ? type : ExprType();
+}
+//--------------------------------------
+
+static uint64_t
+mixHash(
+        uint64_t h,
+        uint64_t value
+)
+{
+        return (h ^ value) * UINT64_C(0x100000001b3);
+}
+
+//--------------------------------------
+/*
+ * Convert a floating value to the integer it equals, if it is a whole
+ * number within the range of long long
+ */
+static bool
+wholeValue(
+        const Literal &value,
+        Literal       &whole
+)
+{
+        if (!(fabsl(value.d) < ldexpl(1, 63))) {
+                return false;
+        }
+
+        whole = Literal(value, ExprType(ExprType::Sign::SIGNED,
+                                        ExprType::Size::LONG_LONG,
+                                        ExprType::Type::INT));
+
+        return whole.type && (static_cast<long double>(whole.i) == value.d);
+}
+
+//--------------------------------------
+/*
+ * Hash of a folded value: integral values, and floating values that are
+ * whole numbers within range, hash as the integer they equal; other
+ * floating values by mantissa and exponent
+ */
+static uint64_t
+valueHash(
+        const Literal &value
+)
+{
+        Literal whole;
+
+        if (!isFloating(value.type)) {
+                return mixHash(UINT64_C(0xcbf29ce484222325), value.u);
+        } else if (wholeValue(value, whole)) {
+                return valueHash(whole);
+        }
+
+        int         exponent;
+        long double mantissa = frexpl(value.d, &exponent);
+
+        return mixHash(mixHash(UINT64_C(0xcbf29ce484222325),
+                               static_cast<uint64_t>(static_cast<intmax_t>(
+                                        ldexpl(mantissa, 62)))),
+                       static_cast<uint64_t>(exponent));
+}
+
+//--------------------------------------
+
+static uint64_t
+spellingHash(
+        const u8string_view &spelling
+)
+{
+        return CityHash64(spelling.char_data(), spelling.bytes());
+}
+
+//--------------------------------------
+
+WRPARSECXX_API
+ExprHasher::ExprHasher(
+        ConstExprEvaluator &evaluator
+) :
+        evaluator_(evaluator)
+{
+}
+
+//--------------------------------------
+/*
+ * Determine if two folded values are mathematically equal, without the
+ * usual arithmetic conversions (under which -1 equals 4294967295u but not
+ * 18446744073709551615ull), so that equal values hash alike
+ */
+static bool
+sameValue(
+        const Literal &a,
+        const Literal &b
+)
+{
+        Literal whole;
+
+        if (isFloating(a.type) && isFloating(b.type)) {
+                return a.d == b.d;
+        } else if (isFloating(a.type)) {
+                return wholeValue(a, whole) && sameValue(whole, b);
+        } else if (isFloating(b.type)) {
+                return wholeValue(b, whole) && sameValue(a, whole);
+        } else if ((a.type.type == ExprType::Type::NULLPTR_T)
+                   != (b.type.type == ExprType::Type::NULLPTR_T)) {
+                return false;
+        }
+
+        // a negative signed value never equals an unsigned one
+        return (a.u == b.u)
+                && ((a.type.isSigned() == b.type.isSigned()) || (a.i >= 0));
+}
+
+//--------------------------------------
+/**
+ * \brief structural hash of an expression
+ *
+ * \param [in] expr
+ *      any expression nonterminal, or a \c constant_expression or
+ *      \c initializer_clause wrapping one
+ * \return
+ *      hash equal to that of every expression \c expr is equivalent to
+ */
+WRPARSECXX_API uint64_t
+ExprHasher::hash(
+        const SPPFNode &expr
+)
+{
+        auto i = memo_.find(&expr);
+
+        if (i != memo_.end()) {
+                return i->second;
+        }
+
+        Literal  value;
+        uint64_t h;
+
+        if (evaluator_.evaluate(expr, value)) {
+                h = valueHash(value);
+        } else {
+                Parts           parts;
+                const SPPFNode &node = unwrap(expr, parts);
+
+                if (node.isTerminal()) {
+                        h = spellingHash(node.firstToken()->spelling());
+                } else {
+                        const char *name = node.nonTerminal()->name();
+
+                        h = CityHash64(name, strlen(name));
+
+                        for (const SPPFNode *part: parts) {
+                                h = mixHash(h, hash(*part));
+                        }
+                }
+        }
+
+        memo_.emplace(&expr, h);
+        return h;
+}
+
+//--------------------------------------
+/**
+ * \brief determine if two expressions are equivalent
+ *
+ * Expressions are equivalent if both fold to constants of the same
+ * mathematical value, or if neither folds and they are identical but for
+ * redundant parentheses and subexpressions that are themselves equivalent.
+ * Unlike areEquivalent(), values are not first brought to a common type,
+ * so \c -1 and \c 4294967295u are not equivalent.
+ */
+WRPARSECXX_API bool
+ExprHasher::equivalent(
+        const SPPFNode &a,
+        const SPPFNode &b
+)
+{
+        if (&a == &b) {
+                return true;
+        } else if (hash(a) != hash(b)) {
+                return false;
+        }
+
+        Literal a_value, b_value;
+        bool    a_folds = evaluator_.evaluate(a, a_value),
+                b_folds = evaluator_.evaluate(b, b_value);
+
+        if (a_folds || b_folds) {
+                return a_folds && b_folds
+                        && sameValue(a_value, b_value);
+        }
+
+        Parts           a_parts, b_parts;
+        const SPPFNode &a_node = unwrap(a, a_parts),
+                       &b_node = unwrap(b, b_parts);
+
+        if (a_node.isTerminal() || b_node.isTerminal()) {
+                return a_node.isTerminal() && b_node.isTerminal()
+                        && (a_node.firstToken()->spelling()
+                            == b_node.firstToken()->spelling());
+        } else if ((a_parts.size() != b_parts.size())
+                   || strcmp(a_node.nonTerminal()->name(),
+                             b_node.nonTerminal()->name())) {
+                return false;
+        }
+
+        for (size_t i = 0; i < a_parts.size(); ++i) {
+                if (!equivalent(*a_parts[i], *b_parts[i])) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+//--------------------------------------
+/**
+ * \brief forget all memoized hashes; the evaluator is not cleared
+ */
+WRPARSECXX_API ExprHasher &
+ExprHasher::clear()
+{
+        memo_.clear();
+        return *this;
+}
+
+//--------------------------------------
+/*
+ * Skip nodes having a single part, such as constant_expression, literal
+ * and id_expression, and redundant parentheses; sets parts to the
+ * non-empty parts of the node returned
+ */
+const SPPFNode &
+ExprHasher::unwrap(
+        const SPPFNode &expr,
+        Parts          &parts
+) const
+{
+        auto           &gram = evaluator_.parser().grammar();
+        const SPPFNode *node = &expr;
+
+        for (;;) {
+                parts.clear();
+
+                if (node->isTerminal()) {
+                        return *node;
+                }
+
+                for (const SPPFNode &part: subProductions(*node)) {
+                        if (!part.empty()) {
+                                parts.push_back(&part);
+                        }
+                }
+
+                if (parts.size() == 1) {
+                        node = parts[0];
+                } else if ((parts.size() == 3)
+                           && node->is(gram.paren_expression)) {
+                        node = parts[1];
+                } else {
+                        return *node;
+                }
+        }
+}
 
 } // namespace cxx
 } // namespace parse
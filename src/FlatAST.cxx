@@ -0,0 +1,264 @@
+/**
+ * \file FlatAST.cxx
+ *
+ * \brief Flattened parse forest export
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <string.h>
+#include <wrutil/numeric_cast.h>
+#include <wrparse/cxx/CXXParser.h>
+#include <wrparse/cxx/FlatAST.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/*
+ * Gather the terminal and nonterminal nodes that are the children of node
+ * in the exported tree, looking through the packed and intermediate nodes
+ * of the forest. Returns true if a derivation other than the first of
+ * node, or of an intermediate node below it, was dropped.
+ */
+static bool
+gatherChildren(
+        const SPPFNode                &node,
+        std::vector<const SPPFNode *> &children
+)
+{
+        bool packed    = false,
+             ambiguous = false;
+
+        for (const SPPFNode &child: node) {
+                if (child.isPackedNode()) {
+                        if (packed) {
+                                ambiguous = true;
+                                continue;
+                        }
+                        packed = true;
+                        ambiguous |= gatherChildren(child, children);
+                } else if (child.isTerminal() || child.isNonTerminal()) {
+                        children.push_back(&child);
+                } else {
+                        ambiguous |= gatherChildren(child, children);
+                }
+        }
+
+        return ambiguous;
+}
+
+//--------------------------------------
+/**
+ * \brief append a parse result
+ *
+ * \param [in] cxx
+ *      parser that produced \c root; consulted for the data attached to
+ *      its nodes
+ * \param [in] root
+ *      node to export along with all its descendants
+ * \return
+ *      index of the node exported for \c root
+ */
+WRPARSECXX_API uint32_t
+FlatAST::add(
+        CXXParser      &cxx,
+        const SPPFNode &root
+)
+{
+        std::unordered_map<const Token *, uint32_t> token_index;
+
+        if (root.firstToken()) {
+                for (const Token *t = root.firstToken(); t; t = t->next()) {
+                        TokenRecord record;
+
+                        // zero padding too, so that images are reproducible
+                        memset(&record, 0, sizeof(record));
+                        record.kind     = t->kind();
+                        record.flags    = t->flags();
+                        record.spelling = numeric_cast<uint32_t>(
+                                                spellings_.size());
+                        record.length   = numeric_cast<uint32_t>(t->bytes());
+                        record.offset   = t->offset();
+
+                        token_index.emplace(
+                                t, numeric_cast<uint32_t>(tokens_.size()));
+                        tokens_.push_back(record);
+                        spellings_.append(t->spelling().char_data(),
+                                          t->bytes());
+                        if (t == root.lastToken()) {
+                                break;
+                        }
+                }
+        }
+
+        auto index_of = [&](const Token *t) {
+                auto i = t ? token_index.find(t) : token_index.end();
+                return (i != token_index.end()) ? i->second : NONE;
+        };
+
+        struct Pending
+        {
+                const SPPFNode *node;    ///< nullptr once node is exported
+                uint32_t        index;   ///< parent, or node once exported
+        };
+
+        std::vector<Pending>          pending { { &root, NONE } };
+        std::vector<uint32_t>         last_child;  // per node, while built
+        std::vector<const SPPFNode *> children;
+        uint32_t                      base = numeric_cast<uint32_t>(
+                                                        nodes_.size());
+
+        while (!pending.empty()) {
+                Pending next = pending.back();
+
+                pending.pop_back();
+
+                if (!next.node) {  // all descendants exported
+                        nodes_[next.index].subtree_end =
+                                numeric_cast<uint32_t>(nodes_.size());
+                        continue;
+                }
+
+                const SPPFNode &node  = *next.node;
+                uint32_t        index = numeric_cast<uint32_t>(nodes_.size());
+                Node            out;
+
+                // zero padding and unused union members too, so that
+                // images are reproducible
+                memset(&out, 0, sizeof(out));
+                out.first_token = index_of(node.firstToken());
+                out.end_token   = out.first_token;
+                out.first_child = out.next_sibling = NONE;
+
+                if (node.lastToken() && !node.empty()) {
+                        uint32_t last = index_of(node.lastToken());
+                        if (last != NONE) {
+                                out.end_token = last + 1;
+                        }
+                }
+
+                children.clear();
+
+                if (node.isTerminal()) {
+                        out.symbol = node.firstToken()->kind();
+                        out.flags = TERMINAL;
+                } else {
+                        out.symbol = symbolFor(node.nonTerminal());
+                        if (gatherChildren(node, children)) {
+                                out.flags |= AMBIGUOUS;
+                        }
+
+                        if (auto spec = cxx.get<CXXParser::DeclSpecifier>(
+                                                                    node)) {
+                                auto &s = out.aux.decl_specifier;
+                                out.aux_type = DECL_SPECIFIER;
+                                s.type_qual = spec->type_qual;
+                                s.sign_spec = spec->sign_spec;
+                                s.size_spec = spec->size_spec;
+                                s.type_spec = spec->type_spec;
+                        } else if (auto dcl = cxx.get<CXXParser::Declarator>(
+                                                                    node)) {
+                                auto &d = out.aux.declarator;
+                                out.aux_type = DECLARATOR;
+                                d.last_ptr = index_of(dcl->last_ptr);
+                                d.begin_parms = index_of(dcl->begin_parms);
+                                d.array = dcl->array;
+                        } else if (auto part =
+                                        cxx.get<CXXParser::DeclaratorPart>(
+                                                                    node)) {
+                                auto &p = out.aux.declarator_part;
+                                out.aux_type = DECLARATOR_PART;
+                                p.count = part->count;
+                                p.qualifiers = part->qualifiers;
+                                p.variadic = part->variadic;
+                        }
+                }
+
+                if (next.index != NONE) {
+                        uint32_t &prev = last_child[next.index - base];
+                        if (prev == NONE) {
+                                nodes_[next.index].first_child = index;
+                        } else {
+                                nodes_[prev].next_sibling = index;
+                        }
+                        prev = index;
+                }
+
+                nodes_.push_back(out);
+                last_child.push_back(NONE);
+                pending.push_back({ nullptr, index });
+
+                for (auto i = children.rbegin(); i != children.rend(); ++i) {
+                        pending.push_back({ *i, index });
+                }
+        }
+
+        roots_.push_back(base);
+        return base;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API FlatAST &
+FlatAST::clear()
+{
+        nodes_.clear();
+        tokens_.clear();
+        roots_.clear();
+        nonterminals_.clear();
+        symbols_.clear();
+        spellings_.clear();
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief nonterminal a node was derived from
+ *
+ * \return
+ *      the nonterminal, or \c nullptr if \c node is a terminal
+ */
+WRPARSECXX_API const NonTerminal *
+FlatAST::nonTerminal(
+        const Node &node
+) const
+{
+        return (node.flags & TERMINAL) ? nullptr : nonterminals_[node.symbol];
+}
+
+//--------------------------------------
+
+uint32_t
+FlatAST::symbolFor(
+        const NonTerminal *nonterminal
+)
+{
+        auto i = symbols_.emplace(nonterminal, numeric_cast<uint32_t>(
+                                                      nonterminals_.size()));
+        if (i.second) {
+                nonterminals_.push_back(nonterminal);
+        }
+        return i.first->second;
+}
+
+
+} // namespace parse
+} // namespace wr
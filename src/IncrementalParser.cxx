@@ -0,0 +1,343 @@
+/**
+ * \file IncrementalParser.cxx
+ *
+ * \brief Incremental reparsing implementation
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <sstream>
+#include <stdexcept>
+#include <wrparse/cxx/CXXLexer.h>
+#include <wrparse/cxx/CXXParser.h>
+#include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/DeclSplitter.h>
+#include <wrparse/cxx/IncrementalParser.h>
+#include <wrparse/cxx/TokenRun.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/*
+ * A top-level declaration: its tokens, and the parser that parsed them,
+ * which owns the tokens referred to by the parse forest
+ */
+struct IncrementalParser::Unit
+{
+        std::unique_ptr<TokenRun>  run;
+        std::unique_ptr<CXXParser> parser;
+        SPPFNode::Ptr              result;
+};
+
+//--------------------------------------
+
+WRPARSECXX_API
+IncrementalParser::IncrementalParser(
+        const CXXOptions &options
+) :
+        options_(options)
+{
+        if (options.have(cxx::SKIP_FUNCTION_BODIES)) {
+                throw std::invalid_argument(
+                        "incremental parsing does not support skipped function bodies");
+        } else if (options.have(cxx::LITERAL_LISTS)) {
+                throw std::invalid_argument(
+                        "incremental parsing does not support literal lists");
+        }
+}
+
+//--------------------------------------
+
+WRPARSECXX_API IncrementalParser::~IncrementalParser() = default;
+
+//--------------------------------------
+/**
+ * \brief report diagnostics from declarations parsed from now on to
+ *      \c handler
+ */
+WRPARSECXX_API IncrementalParser &
+IncrementalParser::addDiagnosticHandler(
+        DiagnosticHandler &handler
+)
+{
+        handlers_.push_back(&handler);
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief parse a complete translation unit, discarding any previous one
+ *
+ * \return
+ *      number of top-level declarations parsed
+ */
+WRPARSECXX_API size_t
+IncrementalParser::parse(
+        const u8string_view &source
+)
+{
+        source_ = source.to_string();
+
+        auto  splitter = split();
+        Units units;
+
+        for (auto &run: splitter->runs()) {
+                units.push_back(parseRun(std::move(run), *splitter));
+        }
+
+        units_.swap(units);
+        splitter_ = std::move(splitter);
+        return units_.size();
+}
+
+//--------------------------------------
+/**
+ * \brief replace part of the source and reparse the declarations affected
+ *
+ * \param [in] offset
+ *      source offset of the text replaced
+ * \param [in] removed
+ *      number of bytes replaced
+ * \param [in] inserted
+ *      replacement text
+ * \return
+ *      number of top-level declarations parsed again
+ * \throw std::out_of_range
+ *      the replaced text lies beyond the end of the source
+ */
+WRPARSECXX_API size_t
+IncrementalParser::edit(
+        size_t               offset,
+        size_t               removed,
+        const u8string_view &inserted
+)
+{
+        if ((offset > source_.size()) || (removed > source_.size() - offset)) {
+                throw std::out_of_range("edit lies beyond end of source");
+        }
+
+        source_.replace(offset, removed, inserted.char_data(),
+                        inserted.bytes());
+
+        ptrdiff_t delta    = static_cast<ptrdiff_t>(inserted.bytes())
+                             - static_cast<ptrdiff_t>(removed);
+        auto      splitter = split();
+        auto     &runs     = splitter->runs();
+        size_t    old_n    = units_.size(),
+                  new_n    = runs.size(),
+                  prefix   = 0,
+                  suffix   = 0;
+
+        /* a declaration ending at, or starting just after, the edited text
+           may have had its last or first token changed */
+        while ((prefix < old_n) && (prefix < new_n)
+                        && (units_[prefix]->run->pastEndOffset() < offset)
+                        && units_[prefix]->run->sameTokens(*runs[prefix])) {
+                ++prefix;
+        }
+
+        while ((suffix < old_n - prefix) && (suffix < new_n - prefix)) {
+                const TokenRun &old_run = *units_[old_n - suffix - 1]->run;
+
+                if ((old_run.beginOffset() <= offset + removed)
+                                || !old_run.sameTokens(
+                                        *runs[new_n - suffix - 1], delta)) {
+                        break;
+                }
+                ++suffix;
+        }
+
+        /* extent of the changed declarations before and after the edit;
+           names declared there may have appeared, gone or changed kind */
+        size_t begin   = prefix ? units_[prefix - 1]->run->pastEndOffset()
+                                : 0,
+               old_end = suffix ? units_[old_n - suffix]->run->beginOffset()
+                                : SIZE_MAX,
+               new_end = suffix ? old_end + delta : SIZE_MAX;
+        Units  units;
+        size_t reparsed = 0;
+
+        for (size_t i = 0; i < prefix; ++i) {
+                units.push_back(std::move(units_[i]));
+        }
+
+        for (size_t i = prefix; i < new_n - suffix; ++i) {
+                units.push_back(parseRun(std::move(runs[i]), *splitter));
+                ++reparsed;
+        }
+
+        for (size_t i = 0; i < suffix; ++i) {
+                auto &unit = units_[old_n - suffix + i];
+                auto &run  = runs[new_n - suffix + i];
+
+                if (usesNames(*unit, *splitter_, begin, old_end, 0)
+                                || usesNames(*unit, *splitter, begin,
+                                             new_end, delta)) {
+                        units.push_back(parseRun(std::move(run), *splitter));
+                        ++reparsed;
+                        continue;
+                }
+
+                // the edit may also have moved it to other lines or columns
+                for (Token &token: unit->parser->tokens()) {
+                        unit->run->relocate(token, *run);
+                }
+                unit->run->relocate(*run);
+
+                units.push_back(std::move(unit));
+        }
+
+        units_.swap(units);
+        splitter_ = std::move(splitter);
+        return reparsed;
+}
+
+//--------------------------------------
+/**
+ * \brief parse forest of a top-level declaration
+ *
+ * \return
+ *      root \c declaration node, or \c nullptr if the declaration failed to
+ *      parse
+ */
+WRPARSECXX_API SPPFNode::ConstPtr
+IncrementalParser::result(
+        size_t index
+) const
+{
+        return units_.at(index)->result;
+}
+
+//--------------------------------------
+/**
+ * \brief parser owning the forest of a top-level declaration, from which
+ *      aux data may be retrieved with CXXParser::get()
+ */
+WRPARSECXX_API CXXParser &
+IncrementalParser::parser(
+        size_t index
+) const
+{
+        return *units_.at(index)->parser;
+}
+
+//--------------------------------------
+/**
+ * \brief source offset of the first token of a top-level declaration
+ */
+WRPARSECXX_API size_t
+IncrementalParser::beginOffset(
+        size_t index
+) const
+{
+        return units_.at(index)->run->beginOffset();
+}
+
+//--------------------------------------
+/**
+ * \brief source offset just past the end of a top-level declaration
+ */
+WRPARSECXX_API size_t
+IncrementalParser::endOffset(
+        size_t index
+) const
+{
+        return units_.at(index)->run->pastEndOffset();
+}
+
+//--------------------------------------
+
+std::unique_ptr<DeclSplitter>
+IncrementalParser::split() const
+{
+        std::istringstream            input(source_);
+        CXXLexer                      lexer(options_, input);
+        std::unique_ptr<DeclSplitter> splitter(new DeclSplitter(lexer));
+
+        splitter->split();
+        return splitter;  // runs and names hold copies of all they need
+}
+
+//--------------------------------------
+
+std::unique_ptr<IncrementalParser::Unit>
+IncrementalParser::parseRun(
+        std::unique_ptr<TokenRun>  run,
+        const DeclSplitter        &splitter
+) const
+{
+        std::unique_ptr<Unit> unit(new Unit);
+
+        unit->run = std::move(run);
+        unit->parser.reset(new CXXParser(options_));
+
+        for (DiagnosticHandler *handler: handlers_) {
+                unit->parser->addDiagnosticHandler(*handler);
+        }
+
+        unit->parser->symbols().setParent(&splitter.names());
+        unit->parser->setLexer(unit->run->rewind());
+        unit->result = unit->parser->parse(unit->parser->grammar().declaration);
+
+        // splitter may not outlive the parser
+        unit->parser->symbols().setParent(nullptr);
+        return unit;
+}
+
+//--------------------------------------
+/*
+ * Determine if any identifier in a declaration refers to a name that the
+ * splitter found declared between offsets begin and end; delta is added to
+ * the declaration's token offsets to match those known to the splitter.
+ */
+bool
+IncrementalParser::usesNames(
+        const Unit         &unit,
+        const DeclSplitter &splitter,
+        size_t              begin,
+        size_t              end,
+        ptrdiff_t           delta
+) const
+{
+        Token token;
+
+        for (unit.run->rewind(); !unit.run->lex(token).is(TOK_EOF); ) {
+                if (!token.is(cxx::TOK_IDENTIFIER)) {
+                        continue;
+                }
+
+                auto sym = splitter.names().lookup(
+                                token.spelling(),
+                                static_cast<size_t>(
+                                        static_cast<ptrdiff_t>(token.offset())
+                                        + delta));
+
+                if (sym && (sym->offset >= begin) && (sym->offset < end)) {
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -0,0 +1,124 @@
+/**
+ * \file LiteralList.cxx
+ *
+ * \brief Literal-only initializer lists read in one pass
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <wrutil/numeric_cast.h>
+#include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/LiteralList.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief append an element
+ *
+ * \param [in] literal
+ *      the element's literal token
+ * \param [in] sign
+ *      \c + or \c - token preceding a numeric literal, if any
+ */
+WRPARSECXX_API LiteralList &
+LiteralList::add(
+        const Token &literal,
+        const Token *sign
+)
+{
+        if (elements_.empty()) {
+                begin_offset_ = sign ? sign->offset() : literal.offset();
+        } else {
+                text_ += ", ";
+        }
+
+        Element element { numeric_cast<uint32_t>(text_.size()), 0,
+                          literal.kind() };
+
+        if (sign && sign->is(cxx::TOK_MINUS)) {
+                text_ += '-';  // read by cxx::Literal as part of the number
+        }
+
+        text_.append(literal.spelling().char_data(),
+                     literal.spelling().bytes());
+        element.length = numeric_cast<uint32_t>(text_.size()
+                                                - element.spelling);
+        elements_.push_back(element);
+        end_offset_ = literal.offset() + literal.spelling().bytes();
+        values_.clear();
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief spelling of an element, including any \c - sign
+ */
+WRPARSECXX_API u8string_view
+LiteralList::spelling(
+        size_t index
+) const
+{
+        const Element &element = elements_[index];
+
+        return { text_.data() + element.spelling, element.length };
+}
+
+//--------------------------------------
+/**
+ * \brief decode an element
+ *
+ * \return
+ *      the element's value; its type is unset for a string literal
+ */
+WRPARSECXX_API cxx::Literal
+LiteralList::value(
+        size_t index
+) const
+{
+        Token token;
+
+        token.setKind(elements_[index].kind).setSpelling(spelling(index));
+        return cxx::Literal(token);
+}
+
+//--------------------------------------
+/**
+ * \brief values of all elements, decoded on first use
+ */
+WRPARSECXX_API const std::vector<cxx::Literal> &
+LiteralList::values()
+{
+        if (values_.size() != elements_.size()) {
+                values_.clear();
+                values_.reserve(elements_.size());
+
+                for (size_t i = 0; i < elements_.size(); ++i) {
+                        values_.push_back(value(i));
+                }
+        }
+
+        return values_;
+}
+
+
+} // namespace parse
+} // namespace wr
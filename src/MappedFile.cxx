@@ -0,0 +1,121 @@
+/**
+ * \file MappedFile.cxx
+ *
+ * \brief Read-only file mapping implementation
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <errno.h>
+#include <string.h>
+#include <fstream>
+#include <stdexcept>
+
+#include <wrutil/Config.h>
+#if WR_POSIX
+#       include <fcntl.h>
+#       include <sys/mman.h>
+#       include <sys/stat.h>
+#       include <unistd.h>
+#endif
+
+#include <wrutil/Format.h>
+#include <wrutil/numeric_cast.h>
+#include <wrparse/cxx/MappedFile.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \param [in] file_path
+ *      file to map
+ * \param [in] description
+ *      what the file holds, for error messages
+ * \throw std::runtime_error
+ *      the file could not be opened or read
+ */
+WRPARSECXX_API
+MappedFile::MappedFile(
+        const char *file_path,
+        const char *description
+)
+{
+#if WR_POSIX
+        int fd = ::open(file_path, O_RDONLY);
+
+        if (fd >= 0) {
+                struct stat st;
+                void       *addr = MAP_FAILED;
+
+                if ((::fstat(fd, &st) == 0) && (st.st_size > 0)) {
+                        bytes_ = numeric_cast<size_t>(st.st_size);
+                        addr = ::mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE,
+                                      fd, 0);
+                }
+
+                ::close(fd);
+
+                if (addr != MAP_FAILED) {
+                        data_ = static_cast<const char *>(addr);
+                        return;
+                }
+
+                bytes_ = 0;
+        }
+#endif
+        std::ifstream input(file_path, std::ios::binary | std::ios::ate);
+
+        if (!input.is_open()) {
+                throw std::runtime_error(printStr(
+                        "cannot open %s \"%s\": %s",
+                        description, file_path, strerror(errno)));
+        }
+
+        bytes_ = numeric_cast<size_t>(static_cast<std::streamoff>(
+                                                              input.tellg()));
+        buffer_.resize((bytes_ + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        input.seekg(0);
+        input.read(reinterpret_cast<char *>(buffer_.data()),
+                   numeric_cast<std::streamsize>(bytes_));
+
+        if (!input) {
+                throw std::runtime_error(printStr(
+                        "error reading %s \"%s\"", description, file_path));
+        }
+
+        data_ = reinterpret_cast<const char *>(buffer_.data());
+}
+
+//--------------------------------------
+
+WRPARSECXX_API
+MappedFile::~MappedFile()
+{
+#if WR_POSIX
+        if (data_ && buffer_.empty()) {
+                ::munmap(const_cast<char *>(data_), bytes_);
+        }
+#endif
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -0,0 +1,464 @@
+/**
+ * \file ParseImage.cxx
+ *
+ * \brief Parse image implementation
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <string.h>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <wrutil/CityHash.h>
+#include <wrutil/Format.h>
+#include <wrutil/numeric_cast.h>
+#include <wrparse/Grammar.h>
+#include <wrparse/cxx/MappedFile.h>
+#include <wrparse/cxx/ParseImage.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/*
+ * Image layout: Header, then header->tokens TokenRecords,
+ * header->diagnostics DiagnosticRecords, header->nodes Nodes,
+ * header->roots root node indices and header->nonterminals Spans naming
+ * nonterminals, then header->pool_bytes bytes of strings referred to by
+ * tokens, diagnostics and Spans. Each part is padded to a multiple of
+ * 8 bytes. All fields are native-endian; byte_order detects images copied
+ * between machines of differing endianness, and the record sizes detect
+ * images written by builds laying out records differently.
+ */
+struct ParseImage::Header
+{
+        char     magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t token_bytes;       ///< \c sizeof(FlatAST::TokenRecord)
+        uint32_t node_bytes;        ///< \c sizeof(FlatAST::Node)
+        uint32_t diagnostic_bytes;  ///< \c sizeof(DiagnosticRecord)
+        uint32_t reserved;          ///< zero
+        uint64_t languages;
+        uint64_t features;
+        uint64_t content_hash;
+        uint64_t tokens;
+        uint64_t diagnostics;
+        uint64_t nodes;
+        uint64_t roots;
+        uint64_t nonterminals;
+        uint64_t pool_bytes;
+};
+
+struct ParseImage::Span
+{
+        uint32_t text;
+        uint32_t length;
+};
+
+static_assert(std::is_trivially_copyable<FlatAST::Node>::value
+                && std::is_trivially_copyable<FlatAST::TokenRecord>::value,
+              "FlatAST records must be usable in place from an image");
+
+static const char     IMAGE_MAGIC[8]   = { 'W', 'R', 'C', 'X', 'X', 'A',
+                                           'S', 'T' };
+static const uint32_t IMAGE_VERSION    = 2;
+static const uint32_t IMAGE_BYTE_ORDER = 0x01020304;
+
+//--------------------------------------
+
+static uint64_t
+padded(
+        uint64_t bytes
+)
+{
+        return (bytes + 7) & ~uint64_t(7);
+}
+
+//--------------------------------------
+
+/*
+ * Deduct the padded size of count records from the remaining bytes of an
+ * image, checking the count before scaling it so that no product can wrap
+ */
+static bool
+takeRecords(
+        uint64_t &remaining,
+        uint64_t  count,
+        uint64_t  record_bytes
+)
+{
+        if (count > remaining / record_bytes) {
+                return false;
+        }
+
+        uint64_t size = padded(count * record_bytes);
+
+        if (size > remaining) {
+                return false;
+        }
+
+        remaining -= size;
+        return true;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API void
+ParseImage::DiagnosticLog::onDiagnostic(
+        const Diagnostic &d
+)
+{
+        records.push_back({ static_cast<uint32_t>(d.category()),
+                            d.line(), d.column(),
+                            numeric_cast<uint32_t>(texts.size()),
+                            numeric_cast<uint32_t>(d.text().size()), 0,
+                            d.offset(), d.bytes() });
+        texts += d.text();
+}
+
+//--------------------------------------
+/**
+ * \param [in] file_path
+ *      image file to load
+ * \param [in] options
+ *      options the source file is to be parsed with
+ * \param [in] content_hash
+ *      hash() of the source file's current text
+ * \throw std::runtime_error
+ *      the file cannot be read or is not a valid image
+ * \throw std::invalid_argument
+ *      the image was written for different source text or options
+ */
+WRPARSECXX_API
+ParseImage::ParseImage(
+        const char       *file_path,
+        const CXXOptions &options,
+        uint64_t          content_hash
+) :
+        mapping_(new MappedFile(file_path, "parse image"))
+{
+        const char *data  = mapping_->data();
+        size_t      bytes = mapping_->size();
+
+        header_ = reinterpret_cast<const Header *>(data);
+
+        if ((bytes < sizeof(Header))
+                        || memcmp(header_->magic, IMAGE_MAGIC,
+                                  sizeof(IMAGE_MAGIC))) {
+                throw std::runtime_error(printStr(
+                        "\"%s\" is not a parse image file", file_path));
+        }
+
+        if ((header_->version != IMAGE_VERSION)
+                        || (header_->byte_order != IMAGE_BYTE_ORDER)
+                        || (header_->token_bytes
+                            != sizeof(FlatAST::TokenRecord))
+                        || (header_->node_bytes != sizeof(FlatAST::Node))
+                        || (header_->diagnostic_bytes
+                            != sizeof(DiagnosticRecord))) {
+                throw std::runtime_error(printStr(
+                        "parse image \"%s\" has incompatible format",
+                        file_path));
+        }
+
+        uint64_t remaining = bytes - sizeof(Header);
+
+        if (!takeRecords(remaining, header_->tokens,
+                         sizeof(FlatAST::TokenRecord))
+                        || !takeRecords(remaining, header_->diagnostics,
+                                        sizeof(DiagnosticRecord))
+                        || !takeRecords(remaining, header_->nodes,
+                                        sizeof(FlatAST::Node))
+                        || !takeRecords(remaining, header_->roots,
+                                        sizeof(uint32_t))
+                        || !takeRecords(remaining, header_->nonterminals,
+                                        sizeof(Span))
+                        || (header_->pool_bytes > remaining)) {
+                throw std::runtime_error(printStr(
+                        "parse image \"%s\" is truncated", file_path));
+        }
+
+        if ((header_->languages != options.languages())
+                        || (header_->features != options.features())) {
+                throw std::invalid_argument(printStr(
+                        "parse image \"%s\" built for different language options",
+                        file_path));
+        }
+
+        if (header_->content_hash != content_hash) {
+                throw std::invalid_argument(printStr(
+                        "parse image \"%s\" built from different source text",
+                        file_path));
+        }
+
+        data += sizeof(Header);
+        tokens_ = reinterpret_cast<const FlatAST::TokenRecord *>(data);
+        data += padded(header_->tokens * sizeof(FlatAST::TokenRecord));
+        diagnostics_ = reinterpret_cast<const DiagnosticRecord *>(data);
+        data += padded(header_->diagnostics * sizeof(DiagnosticRecord));
+        nodes_ = reinterpret_cast<const FlatAST::Node *>(data);
+        data += padded(header_->nodes * sizeof(FlatAST::Node));
+        roots_ = reinterpret_cast<const uint32_t *>(data);
+        data += padded(header_->roots * sizeof(uint32_t));
+        names_ = reinterpret_cast<const Span *>(data);
+        data += padded(header_->nonterminals * sizeof(Span));
+        pool_ = data;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API ParseImage::~ParseImage() = default;
+
+//--------------------------------------
+/**
+ * \brief hash of source text, identifying the text an image was parsed
+ *      from
+ */
+WRPARSECXX_API uint64_t
+ParseImage::hash(
+        const u8string_view &source
+) // static
+{
+        return CityHash64(source.char_data(), source.bytes());
+}
+
+//--------------------------------------
+/**
+ * \brief write the image of a flattened parse
+ *
+ * \param [out] output
+ *      binary stream to write image to
+ * \param [in] ast
+ *      parse of the source file
+ * \param [in] diagnostics
+ *      diagnostics reported while parsing it
+ * \param [in] options
+ *      options it was parsed with
+ * \param [in] content_hash
+ *      hash() of the source file's text
+ */
+WRPARSECXX_API void
+ParseImage::write(
+        std::ostream        &output,
+        const FlatAST       &ast,
+        const DiagnosticLog &diagnostics,
+        const CXXOptions    &options,
+        uint64_t             content_hash
+) // static
+{
+        std::string                   pool = ast.spellings();
+        std::vector<Span>             names;
+        std::vector<DiagnosticRecord> records = diagnostics.records;
+
+        for (const NonTerminal *nonterminal: ast.nonTerminals()) {
+                const char *name = nonterminal->name();
+                names.push_back({ numeric_cast<uint32_t>(pool.size()),
+                                  numeric_cast<uint32_t>(strlen(name)) });
+                pool += name;
+        }
+
+        uint32_t texts = numeric_cast<uint32_t>(pool.size());
+
+        for (DiagnosticRecord &record: records) {
+                record.text = numeric_cast<uint32_t>(record.text + texts);
+        }
+
+        pool += diagnostics.texts;
+
+        Header header;
+
+        memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+        header.version          = IMAGE_VERSION;
+        header.byte_order       = IMAGE_BYTE_ORDER;
+        header.token_bytes      = sizeof(FlatAST::TokenRecord);
+        header.node_bytes       = sizeof(FlatAST::Node);
+        header.diagnostic_bytes = sizeof(DiagnosticRecord);
+        header.reserved         = 0;
+        header.languages        = options.languages();
+        header.features         = options.features();
+        header.content_hash     = content_hash;
+        header.tokens           = ast.tokens().size();
+        header.diagnostics      = records.size();
+        header.nodes            = ast.nodes().size();
+        header.roots            = ast.roots().size();
+        header.nonterminals     = names.size();
+        header.pool_bytes       = pool.size();
+
+        auto put = [&output](const void *data, size_t bytes) {
+                static const char zeros[8] = {};
+
+                output.write(static_cast<const char *>(data),
+                             numeric_cast<std::streamsize>(bytes));
+                output.write(zeros, numeric_cast<std::streamsize>(
+                                                padded(bytes) - bytes));
+        };
+
+        put(&header, sizeof(header));
+        put(ast.tokens().data(),
+            ast.tokens().size() * sizeof(FlatAST::TokenRecord));
+        put(records.data(), records.size() * sizeof(DiagnosticRecord));
+        put(ast.nodes().data(), ast.nodes().size() * sizeof(FlatAST::Node));
+        put(ast.roots().data(), ast.roots().size() * sizeof(uint32_t));
+        put(names.data(), names.size() * sizeof(Span));
+        output.write(pool.data(), numeric_cast<std::streamsize>(pool.size()));
+}
+
+//--------------------------------------
+
+WRPARSECXX_API uint64_t
+ParseImage::contentHash() const
+{
+        return header_->content_hash;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API cxx::Languages
+ParseImage::languages() const
+{
+        return header_->languages;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API cxx::Features
+ParseImage::features() const
+{
+        return header_->features;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+ParseImage::nodeCount() const
+{
+        return numeric_cast<size_t>(header_->nodes);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+ParseImage::tokenCount() const
+{
+        return numeric_cast<size_t>(header_->tokens);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API u8string_view
+ParseImage::spelling(
+        const FlatAST::TokenRecord &token
+) const
+{
+        return string(token.spelling, token.length);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+ParseImage::rootCount() const
+{
+        return numeric_cast<size_t>(header_->roots);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+ParseImage::nonTerminalCount() const
+{
+        return numeric_cast<size_t>(header_->nonterminals);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API u8string_view
+ParseImage::nonTerminalName(
+        size_t index
+) const
+{
+        if (index >= header_->nonterminals) {
+                throw std::runtime_error("corrupt parse image");
+        }
+        return string(names_[index].text, names_[index].length);
+}
+
+//--------------------------------------
+/**
+ * \brief name of the nonterminal a node was derived from
+ *
+ * \return
+ *      the name, or an empty string if \c node is a terminal
+ */
+WRPARSECXX_API u8string_view
+ParseImage::nonTerminalName(
+        const FlatAST::Node &node
+) const
+{
+        return (node.flags & FlatAST::TERMINAL) ? u8string_view()
+                                                : nonTerminalName(node.symbol);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+ParseImage::diagnosticCount() const
+{
+        return numeric_cast<size_t>(header_->diagnostics);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API const ParseImage::DiagnosticRecord &
+ParseImage::diagnostic(
+        size_t index
+) const
+{
+        return diagnostics_[index];
+}
+
+//--------------------------------------
+
+WRPARSECXX_API u8string_view
+ParseImage::text(
+        const DiagnosticRecord &diagnostic
+) const
+{
+        return string(diagnostic.text, diagnostic.length);
+}
+
+//--------------------------------------
+
+u8string_view
+ParseImage::string(
+        uint32_t offset,
+        uint32_t length
+) const
+{
+        if ((uint64_t(offset) + length) > header_->pool_bytes) {
+                throw std::runtime_error("corrupt parse image");
+        }
+        return { pool_ + offset, length };
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -0,0 +1,301 @@
+/**
+ * \file ParseMemo.cxx
+ *
+ * \brief Memo table of completed derivations
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <ostream>
+#include <wrutil/Format.h>
+#include <wrparse/cxx/ParseMemo.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/*
+ * Approximate cost of a start token's table slot and of each derivation
+ * recorded under it, including container overheads but not its shape
+ */
+static const size_t START_BYTES = 64,
+                    ENTRY_BYTES = 64;
+
+//--------------------------------------
+
+WRPARSECXX_API
+ParseMemo::ParseMemo(
+        size_t budget  ///< approximate limit on memory held, in bytes
+) :
+        budget_(budget)
+{
+}
+
+//--------------------------------------
+/**
+ * \brief change the memory limit, forgetting derivations if now over it
+ */
+WRPARSECXX_API ParseMemo &
+ParseMemo::setBudget(
+        size_t budget
+)
+{
+        budget_ = budget;
+        evict(0);
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief forget all derivations and reset statistics
+ */
+WRPARSECXX_API ParseMemo &
+ParseMemo::clear()
+{
+        clearDerivations();
+        stats_ = Stats();
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief forget all derivations, releasing the data held, but keep
+ *      statistics
+ */
+WRPARSECXX_API ParseMemo &
+ParseMemo::clearDerivations()
+{
+        table_.clear();
+        order_.clear();
+        stats_.bytes = 0;
+        return *this;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API void
+ParseMemo::report(
+        std::ostream &output
+) const
+{
+        uint64_t lookups = stats_.hits + stats_.misses;
+
+        print(output, "memo: %u hits, %u misses (%u%% hit rate), "
+                      "%u evictions, peak %u KiB of %u KiB\n",
+              stats_.hits, stats_.misses,
+              lookups ? (stats_.hits * 100 / lookups) : 0,
+              stats_.evictions, (stats_.peak_bytes + 1023) / 1024,
+              budget_ / 1024);
+}
+
+//--------------------------------------
+
+const ParseMemo::Entry *
+ParseMemo::recall(
+        const NonTerminal &nonterminal,
+        const SPPFNode    &node
+)
+{
+        auto i = table_.find(Start(&nonterminal, node.firstToken()->offset()));
+
+        if (i != table_.end()) {
+                size_t last   = node.lastToken()->offset(),
+                       hash   = 0;
+                bool   hashed = false;
+
+                for (const Entry &entry: i->second) {
+                        if (entry.last != last) {
+                                continue;
+                        } else if (!hashed) {
+                                hash = hashOf(node);
+                                hashed = true;
+                        }
+
+                        if ((entry.hash == hash)
+                                        && sameShape(entry.shape, node)) {
+                                ++stats_.hits;
+                                return &entry;
+                        }
+                }
+        }
+
+        ++stats_.misses;
+        return nullptr;
+}
+
+//--------------------------------------
+
+void
+ParseMemo::remember(
+        const NonTerminal  &nonterminal,
+        const SPPFNode     &node,
+        const AuxData::Ptr &aux,
+        bool                accepted
+)
+{
+        Start  key(&nonterminal, node.firstToken()->offset());
+        Entry  entry { node.lastToken()->offset(), 0, shapeOf(node),
+                       accepted ? aux : AuxData::Ptr(), accepted };
+        size_t bytes = bytesOf(entry);
+
+        if (START_BYTES + bytes > budget_) {
+                return;
+        }
+
+        entry.hash = hashOf(node);
+        evict(START_BYTES + bytes);
+
+        auto i = table_.find(key);
+
+        if (i == table_.end()) {
+                i = table_.emplace(key, std::vector<Entry>()).first;
+                order_.push_back(key);
+                bytes += START_BYTES;
+        }
+
+        i->second.push_back(std::move(entry));
+
+        stats_.bytes += bytes;
+        if (stats_.bytes > stats_.peak_bytes) {
+                stats_.peak_bytes = stats_.bytes;
+        }
+}
+
+//--------------------------------------
+
+/*
+ * Summary of one immediate sub-derivation: the nonterminal (or token) it
+ * derives and where it ends
+ */
+ParseMemo::Part
+ParseMemo::partOf(
+        const SPPFNode &sub
+) // static
+{
+        const Token *last = sub.lastToken();
+
+        return { sub.nonTerminal(),
+                 sub.isTerminal() ? sub.firstToken()->kind() : TokenKind(0),
+                 last ? last->offset() : SIZE_MAX };
+}
+
+//--------------------------------------
+
+/*
+ * Summary of a derivation's immediate sub-derivations. Derivations of one
+ * nonterminal over the same tokens differing in shape are judged
+ * separately. Unlike the derivation itself, a shape keeps no SPPF nodes
+ * alive. Only built for derivations being remembered; lookups walk the
+ * node instead (see hashOf() and sameShape()).
+ */
+std::vector<ParseMemo::Part>
+ParseMemo::shapeOf(
+        const SPPFNode &node
+) // static
+{
+        std::vector<Part> shape;
+
+        for (const SPPFNode &sub: subProductions(node)) {
+                shape.push_back(partOf(sub));
+        }
+
+        return shape;
+}
+
+//--------------------------------------
+
+size_t
+ParseMemo::hashOf(
+        const SPPFNode &node
+) // static
+{
+        size_t hash = 0;
+
+        for (const SPPFNode &sub: subProductions(node)) {
+                Part part = partOf(sub);
+
+                hash = (hash * 31)
+                       + std::hash<const void *>()(part.nonterminal);
+                hash = (hash * 31) + part.kind;
+                hash = (hash * 31) + part.last;
+        }
+
+        return hash;
+}
+
+//--------------------------------------
+
+bool
+ParseMemo::sameShape(
+        const std::vector<Part> &shape,
+        const SPPFNode          &node
+) // static
+{
+        auto part = shape.begin();
+
+        for (const SPPFNode &sub: subProductions(node)) {
+                if ((part == shape.end()) || !(*part++ == partOf(sub))) {
+                        return false;
+                }
+        }
+
+        return part == shape.end();
+}
+
+//--------------------------------------
+
+/*
+ * approximate memory held by an entry, including its shape
+ */
+size_t
+ParseMemo::bytesOf(
+        const Entry &entry
+) // static
+{
+        return ENTRY_BYTES + entry.shape.capacity() * sizeof(Part);
+}
+
+//--------------------------------------
+
+/*
+ * Forget the longest-held start tokens until another \c bytes fit within
+ * budget
+ */
+void
+ParseMemo::evict(
+        size_t bytes
+)
+{
+        while (!order_.empty() && (stats_.bytes + bytes > budget_)) {
+                auto i = table_.find(order_.front());
+
+                stats_.bytes -= START_BYTES;
+                for (const Entry &entry: i->second) {
+                        stats_.bytes -= bytesOf(entry);
+                }
+                ++stats_.evictions;
+                table_.erase(i);
+                order_.pop_front();
+        }
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -0,0 +1,177 @@
+/**
+ * \file ParseProfile.cxx
+ *
+ * \brief Per-nonterminal parse profiling implementation
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <algorithm>
+#include <ostream>
+#include <wrutil/Format.h>
+#include <wrparse/Grammar.h>
+#include <wrparse/SPPF.h>
+#include <wrparse/cxx/ParseProfile.h>
+
+
+namespace wr {
+namespace parse {
+
+
+WRPARSECXX_API ParseProfile &
+ParseProfile::clear()
+{
+        stats_.clear();
+        pending_.clear();
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief retrieve statistics for every nonterminal attempted so far
+ *
+ * \return
+ *      one entry per nonterminal, in order of descending time and then
+ *      descending attempts
+ */
+WRPARSECXX_API std::vector<ParseProfile::Entry>
+ParseProfile::entries() const
+{
+        std::vector<Entry> result;
+
+        result.reserve(stats_.size());
+
+        for (auto &stat: stats_) {
+                result.push_back(stat.second);
+        }
+
+        std::sort(result.begin(), result.end(),
+                  [](const Entry &a, const Entry &b) {
+                        return (a.time > b.time)
+                                || ((a.time == b.time)
+                                    && (a.attempts > b.attempts));
+                  });
+
+        return result;
+}
+
+//--------------------------------------
+/**
+ * \brief write a table of statistics, most costly nonterminals first
+ *
+ * \param [out] output
+ *      stream to write report to
+ * \param [in] limit
+ *      maximum number of nonterminals to list
+ */
+WRPARSECXX_API void
+ParseProfile::report(
+        std::ostream &output,
+        size_t        limit
+) const
+{
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+
+        auto all = entries();
+
+        print(output, "%-36s %10s %10s %10s %10s %12s\n", "nonterminal",
+              "attempts", "successes", "nodes", "ambiguous", "time (us)");
+
+        for (const Entry &entry: all) {
+                if (!limit--) {
+                        break;
+                }
+
+                print(output, "%-36s %10u %10u %10u %10u %12u\n",
+                      entry.nonterminal->name(), entry.attempts,
+                      entry.successes, entry.nodes, entry.ambiguous,
+                      duration_cast<microseconds>(entry.time).count());
+        }
+}
+
+//--------------------------------------
+
+void
+ParseProfile::enter(
+        const NonTerminal &nonterminal,
+        const Token       *input
+)
+{
+        auto &entry = stats_[&nonterminal];
+
+        entry.nonterminal = &nonterminal;
+        ++entry.attempts;
+        pending_.emplace(Attempt(&nonterminal, input), clock::now());
+}
+
+//--------------------------------------
+
+void
+ParseProfile::leave(
+        const NonTerminal &nonterminal,
+        const Token       *input,
+        const SPPFNode    *result
+)
+{
+        auto &entry = stats_[&nonterminal];
+        auto  i     = pending_.find(Attempt(&nonterminal, input));
+
+        entry.nonterminal = &nonterminal;
+
+        if (i != pending_.end()) {
+                entry.time += clock::now() - i->second;
+                pending_.erase(i);
+        }
+
+        if (!result) {
+                return;
+        }
+
+        size_t packed = 0;
+
+        for (const SPPFNode &child: *result) {
+                if (child.isPackedNode()) {
+                        ++packed;
+                }
+        }
+
+        ++entry.successes;
+        entry.nodes += 1 + packed;
+
+        if (packed > 1) {
+                ++entry.ambiguous;
+        }
+}
+
+//--------------------------------------
+
+/*
+ * Called at the end of each parse: forget attempts that never completed,
+ * whose tokens the parser may now release and reuse
+ */
+void
+ParseProfile::finish()
+{
+        pending_.clear();
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -0,0 +1,328 @@
+/**
+ * \file PrecompiledTokens.cxx
+ *
+ * \brief Precompiled token image implementation
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <string.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wrutil/Format.h>
+#include <wrutil/numeric_cast.h>
+#include <wrparse/cxx/CXXLexer.h>
+#include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/MappedFile.h>
+#include <wrparse/cxx/PrecompiledTokens.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/*
+ * Image layout: Header, then header->tokens Records, then
+ * header->identifiers Spans, then header->pool_bytes bytes of spelling text.
+ * All fields are native-endian; byte_order detects images copied between
+ * machines of differing endianness.
+ */
+struct PrecompiledTokens::Header
+{
+        char     magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t languages;
+        uint64_t features;
+        uint64_t tokens;
+        uint64_t identifiers;
+        uint64_t pool_bytes;
+        uint64_t source_bytes;
+};
+
+struct PrecompiledTokens::Record
+{
+        uint32_t kind;
+        uint32_t flags;
+        uint32_t spelling;  ///< offset into spelling pool
+        uint32_t length;    ///< spelling length in bytes
+        uint32_t offset;    ///< source offset within prefix header
+        uint32_t line;
+        uint32_t column;
+};
+
+struct PrecompiledTokens::Span
+{
+        uint32_t spelling;
+        uint32_t length;
+};
+
+static const char     IMAGE_MAGIC[8]   = { 'W', 'R', 'C', 'X', 'X', 'T',
+                                           'O', 'K' };
+static const uint32_t IMAGE_VERSION    = 3;
+static const uint32_t IMAGE_BYTE_ORDER = 0x01020304;
+
+//--------------------------------------
+
+WRPARSECXX_API
+PrecompiledTokens::PrecompiledTokens(
+        const char       *file_path,
+        const CXXOptions &options
+) :
+        mapping_(new MappedFile(file_path, "precompiled tokens"))
+{
+        const char *data  = mapping_->data();
+        size_t      bytes = mapping_->size();
+
+        header_ = reinterpret_cast<const Header *>(data);
+
+        if ((bytes < sizeof(Header))
+                        || memcmp(header_->magic, IMAGE_MAGIC,
+                                  sizeof(IMAGE_MAGIC))) {
+                throw std::runtime_error(printStr(
+                        "\"%s\" is not a precompiled tokens file", file_path));
+        }
+
+        if ((header_->version != IMAGE_VERSION)
+                        || (header_->byte_order != IMAGE_BYTE_ORDER)) {
+                throw std::runtime_error(printStr(
+                        "precompiled tokens \"%s\" has incompatible format",
+                        file_path));
+        }
+
+        // check each count before scaling it so that no product can wrap
+        uint64_t remaining = bytes - sizeof(Header);
+        bool     truncated = header_->tokens > remaining / sizeof(Record);
+
+        if (!truncated) {
+                remaining -= header_->tokens * sizeof(Record);
+                truncated = header_->identifiers > remaining / sizeof(Span);
+        }
+        if (!truncated) {
+                remaining -= header_->identifiers * sizeof(Span);
+                truncated = header_->pool_bytes > remaining;
+        }
+
+        if (truncated) {
+                throw std::runtime_error(printStr(
+                        "precompiled tokens \"%s\" is truncated", file_path));
+        }
+
+        if (!compatibleWith(options)) {
+                throw std::invalid_argument(printStr(
+                        "precompiled tokens \"%s\" built for different language options",
+                        file_path));
+        }
+
+        data += sizeof(Header);
+        records_ = reinterpret_cast<const Record *>(data);
+        data += header_->tokens * sizeof(Record);
+        identifiers_ = reinterpret_cast<const Span *>(data);
+        data += header_->identifiers * sizeof(Span);
+        pool_ = data;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API PrecompiledTokens::~PrecompiledTokens() = default;
+
+//--------------------------------------
+/**
+ * \brief lex the entirety of a prefix header and write its token image
+ *
+ * \param [out] output
+ *      binary stream to write image to
+ * \param [in] lexer
+ *      lexer positioned at the start of the prefix header; its options
+ *      determine which options the image may be loaded with
+ */
+WRPARSECXX_API void
+PrecompiledTokens::write(
+        std::ostream &output,
+        CXXLexer     &lexer
+) // static
+{
+        std::vector<Record>                        records;
+        std::vector<Span>                          identifiers;
+        std::string                                pool;
+        std::unordered_map<std::string, uint32_t>  pooled;
+        Token                                      token;
+        size_t                                     source_bytes = 0;
+
+        auto add_spelling = [&](const u8string_view &spelling) {
+                auto i = pooled.emplace(spelling.to_string(),
+                                        numeric_cast<uint32_t>(pool.size()));
+                if (i.second) {
+                        pool.append(spelling.char_data(), spelling.bytes());
+                }
+                return i;
+        };
+
+        while (lexer.lex(token).kind() != TOK_EOF) {
+                auto  i = add_spelling(token.spelling());
+                Span  span { i.first->second,
+                             numeric_cast<uint32_t>(token.spelling().bytes()) };
+
+                if (token.is(cxx::TOK_IDENTIFIER) && i.second) {
+                        identifiers.push_back(span);
+                }
+
+                records.push_back({ token.kind(), token.flags(),
+                                    span.spelling, span.length,
+                                    numeric_cast<uint32_t>(token.offset()),
+                                    numeric_cast<uint32_t>(token.line()),
+                                    numeric_cast<uint32_t>(token.column()) });
+                source_bytes = token.offset() + token.spelling().bytes();
+        }
+
+        const CXXOptions &options = lexer.options();
+        Header            header;
+
+        memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+        header.version      = IMAGE_VERSION;
+        header.byte_order   = IMAGE_BYTE_ORDER;
+        header.languages    = options.languages();
+        header.features     = options.features();
+        header.tokens       = records.size();
+        header.identifiers  = identifiers.size();
+        header.pool_bytes   = pool.size();
+        header.source_bytes = source_bytes;
+
+        output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char *>(records.data()),
+                     numeric_cast<std::streamsize>(
+                                        records.size() * sizeof(Record)));
+        output.write(reinterpret_cast<const char *>(identifiers.data()),
+                     numeric_cast<std::streamsize>(
+                                        identifiers.size() * sizeof(Span)));
+        output.write(pool.data(), numeric_cast<std::streamsize>(pool.size()));
+}
+
+//--------------------------------------
+
+WRPARSECXX_API cxx::Languages
+PrecompiledTokens::languages() const
+{
+        return header_->languages;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API cxx::Features
+PrecompiledTokens::features() const
+{
+        return header_->features;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API bool
+PrecompiledTokens::compatibleWith(
+        const CXXOptions &options
+) const
+{
+        return (header_->languages == options.languages())
+                && (header_->features == options.features());
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+PrecompiledTokens::size() const
+{
+        return numeric_cast<size_t>(header_->tokens);
+}
+
+//--------------------------------------
+/**
+ * \brief length of the prefix header's source text
+ *
+ * Tokens lexed after the prefix has been replayed are offset by this amount
+ * so that token offsets increase monotonically across prefix and input.
+ */
+WRPARSECXX_API size_t
+PrecompiledTokens::sourceBytes() const
+{
+        return numeric_cast<size_t>(header_->source_bytes);
+}
+
+//--------------------------------------
+/**
+ * \brief retrieve a token from the image
+ *
+ * Sets the kind, flags, spelling, offset, line and column of \c token; the
+ * spelling refers into the image itself and remains valid for the lifetime
+ * of \c *this.
+ */
+WRPARSECXX_API Token &
+PrecompiledTokens::get(
+        size_t  index,
+        Token  &token
+) const
+{
+        const Record &record = records_[index];
+
+        return token.setKind(numeric_cast<TokenKind>(record.kind))
+                    .setFlags(numeric_cast<TokenFlags>(record.flags))
+                    .setSpelling(spelling(record.spelling, record.length))
+                    .setLine(record.line)
+                    .setColumn(record.column)
+                    .adjustOffset(static_cast<ptrdiff_t>(record.offset)
+                                  - static_cast<ptrdiff_t>(token.offset()));
+}
+
+//--------------------------------------
+
+WRPARSECXX_API size_t
+PrecompiledTokens::identifierCount() const
+{
+        return numeric_cast<size_t>(header_->identifiers);
+}
+
+//--------------------------------------
+
+WRPARSECXX_API u8string_view
+PrecompiledTokens::identifier(
+        size_t index
+) const
+{
+        return spelling(identifiers_[index].spelling,
+                        identifiers_[index].length);
+}
+
+//--------------------------------------
+
+u8string_view
+PrecompiledTokens::spelling(
+        uint32_t offset,
+        uint32_t length
+) const
+{
+        if ((uint64_t(offset) + length) > header_->pool_bytes) {
+                throw std::runtime_error("corrupt precompiled tokens image");
+        }
+        return { pool_ + offset, length };
+}
+
+
+} // namespace parse
+} // namespace wr
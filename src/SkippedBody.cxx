@@ -0,0 +1,65 @@
+/**
+ * \file SkippedBody.cxx
+ *
+ * \brief Function bodies passed over by the parser
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <wrparse/cxx/CXXOptions.h>
+#include <wrparse/cxx/CXXParser.h>
+#include <wrparse/cxx/SkippedBody.h>
+#include <wrparse/cxx/SymbolTable.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief parse the body as a \c compound_statement
+ *
+ * \param [in] parser
+ *      parser to use, which must not be the one that skipped the body;
+ *      its lexer is replaced by \c *this, which must therefore outlive any
+ *      use of the result; its symbols() are cleared
+ * \param [in] scope
+ *      names to look up besides those the body declares, normally the
+ *      symbols() of the parser that skipped the body, which must outlive
+ *      the parse. As tokens keep their source offsets, this finds the
+ *      names visible at the body, just as parsing the body in place would.
+ * \return
+ *      the parsed compound-statement, or \c nullptr on error
+ */
+WRPARSECXX_API SPPFNode::Ptr
+SkippedBody::parse(
+        CXXParser         &parser,
+        const SymbolTable &scope
+)
+{
+        rewind();
+        parser.reset();
+        parser.symbols().clear().setParent(&scope);
+        parser.setLexer(*this);
+        return parser.parse(parser.grammar().compound_statement);
+}
+
+
+} // namespace parse
+} // namespace wr
@@ -0,0 +1,272 @@
+/**
+ * \file SymbolTable.cxx
+ *
+ * \brief Scoped table of names declared during parsing
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <algorithm>
+#include <wrparse/cxx/SymbolTable.h>
+
+
+namespace wr {
+namespace parse {
+
+
+/**
+ * \brief record a declared name
+ *
+ * Declaring the same name at the same offset more than once (as happens when
+ * the parser explores alternative parses of a declaration) merges the kinds
+ * given rather than adding a further symbol.
+ *
+ * \param [in] name
+ *      declared name; copied into the table
+ * \param [in] kind
+ *      combination of \c Kind values
+ * \param [in] offset
+ *      source offset of the token declaring the name
+ */
+WRPARSECXX_API SymbolTable &
+SymbolTable::declare(
+        const u8string_view &name,
+        uint8_t              kind,
+        size_t               offset
+)
+{
+        auto i = table_.find(name);
+
+        if (i == table_.end()) {
+                names_.emplace_front(name.char_data(), name.bytes());
+                i = table_.emplace(u8string_view(names_.front()),
+                                   std::vector<Symbol>()).first;
+        }
+
+        std::vector<Symbol> &entries = i->second;
+
+        for (Symbol &sym: entries) {
+                if (sym.offset == offset) {
+                        if ((kind & ~sym.kind & TEMPLATE_PARAMETER)
+                                        && (sym.scope_end == SIZE_MAX)) {
+                                open_templ_parms_.insert(
+                                        std::upper_bound(
+                                                open_templ_parms_.begin(),
+                                                open_templ_parms_.end(),
+                                                offset),
+                                        offset);
+                        }
+                        sym.kind |= kind;
+                        return *this;
+                }
+        }
+
+        entries.push_back({ i->first, kind, offset, SIZE_MAX });
+        ++count_;
+
+        OpenSymbol open = { offset, &entries, entries.size() - 1 };
+        auto       pos  = open_.end();
+
+        declared_.push_back(open);
+
+        while ((pos != open_.begin()) && ((pos - 1)->offset > offset)) {
+                --pos;  // usually declared in order so rarely iterates
+        }
+
+        open_.insert(pos, open);
+
+        if (kind & TEMPLATE_PARAMETER) {
+                open_templ_parms_.insert(
+                        std::upper_bound(open_templ_parms_.begin(),
+                                         open_templ_parms_.end(), offset),
+                        offset);
+        }
+
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief end the scope of names declared within a source range
+ *
+ * \param [in] begin
+ *      offset of the token opening the scope; names declared at this offset
+ *      are not affected
+ * \param [in] end
+ *      offset of the token closing the scope
+ * \param [in] kinds
+ *      only symbols having one of these \c Kind bits are affected
+ */
+WRPARSECXX_API SymbolTable &
+SymbolTable::closeScope(
+        size_t  begin,
+        size_t  end,
+        uint8_t kinds
+)
+{
+        auto by_offset = [](const OpenSymbol &open, size_t offset) {
+                return open.offset < offset;
+        };
+
+        auto first = std::lower_bound(open_.begin(), open_.end(), begin + 1,
+                                      by_offset),
+             last  = std::lower_bound(first, open_.end(), end, by_offset);
+
+        auto closed = [&](const OpenSymbol &open) {
+                Symbol &sym = (*open.entries)[open.index];
+
+                if (!(sym.kind & kinds)) {
+                        return false;
+                }
+
+                sym.scope_end = end;
+
+                if (sym.kind & TEMPLATE_PARAMETER) {
+                        auto i = std::lower_bound(open_templ_parms_.begin(),
+                                                  open_templ_parms_.end(),
+                                                  sym.offset);
+                        if ((i != open_templ_parms_.end())
+                                        && (*i == sym.offset)) {
+                                open_templ_parms_.erase(i);
+                        }
+                }
+
+                return true;
+        };
+
+        open_.erase(std::remove_if(first, last, closed), last);
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief remove the symbols declared at or after a source offset
+ *
+ * Used to discard the names entered while parsing alternatives of a
+ * declaration before entering those of the parse finally accepted. The
+ * symbols withdrawn must have been declared after all others, as is the
+ * case when \c offset is that of the first token of the declaration most
+ * recently parsed.
+ *
+ * \param [in] offset
+ *      source offset of the first token whose names are withdrawn
+ */
+WRPARSECXX_API SymbolTable &
+SymbolTable::withdraw(
+        size_t offset
+)
+{
+        while (!declared_.empty() && (declared_.back().offset >= offset)) {
+                std::vector<Symbol> &entries = *declared_.back().entries;
+
+                declared_.pop_back();
+                entries.pop_back();
+                --count_;
+        }
+
+        auto by_offset = [](const OpenSymbol &open, size_t offset) {
+                return open.offset < offset;
+        };
+
+        open_.erase(std::lower_bound(open_.begin(), open_.end(), offset,
+                                     by_offset),
+                    open_.end());
+        open_templ_parms_.erase(std::lower_bound(open_templ_parms_.begin(),
+                                                 open_templ_parms_.end(),
+                                                 offset),
+                                open_templ_parms_.end());
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief find the symbol a name refers to at a given source offset
+ *
+ * \param [in] name
+ *      name to look up
+ * \param [in] offset
+ *      source offset at which the name is used
+ * \param [in] kinds
+ *      only consider symbols having one of these \c Kind bits; C uses this
+ *      to keep struct, union and enum tags apart from ordinary identifiers
+ * \return
+ *      most recently declared matching symbol visible at \c offset, whether
+ *      held by \c *this or its parent table, or \c nullptr if none
+ */
+WRPARSECXX_API const SymbolTable::Symbol *
+SymbolTable::lookup(
+        const u8string_view &name,
+        size_t               offset,
+        uint8_t              kinds
+) const
+{
+        const Symbol *found = parent_ ? parent_->lookup(name, offset, kinds)
+                                      : nullptr;
+        auto          i     = table_.find(name);
+
+        if (i == table_.end()) {
+                return found;
+        }
+
+        for (const Symbol &sym: i->second) {
+                if ((sym.kind & kinds) && (sym.offset < offset)
+                                       && (offset <= sym.scope_end)
+                                       && (!found
+                                           || (sym.offset > found->offset))) {
+                        found = &sym;
+                }
+        }
+
+        return found;
+}
+
+//--------------------------------------
+/**
+ * \brief determine if an offset lies within a template declaration whose
+ *      parameters are still in scope
+ */
+WRPARSECXX_API bool
+SymbolTable::inTemplate(
+        size_t offset
+) const
+{
+        return !open_templ_parms_.empty()
+                && (open_templ_parms_.front() < offset);
+}
+
+//--------------------------------------
+
+/**
+ * \brief remove all symbols; the parent table, if any, is retained
+ */
+WRPARSECXX_API SymbolTable &
+SymbolTable::clear()
+{
+        open_templ_parms_.clear();
+        declared_.clear();
+        open_.clear();
+        table_.clear();
+        names_.clear();
+        count_ = 0;
+        return *this;
+}
+
+
+} // namespace parse
+} // namespace wr
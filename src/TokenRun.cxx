@@ -0,0 +1,209 @@
+/**
+ * \file TokenRun.cxx
+ *
+ * \brief Replayable run of tokens
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <algorithm>
+#include <wrparse/cxx/TokenRun.h>
+
+
+namespace wr {
+namespace parse {
+
+
+WRPARSECXX_API TokenRun::TokenRun() = default;
+
+//--------------------------------------
+/**
+ * \brief replay the next token of the run; \c TOK_EOF once all have been
+ *      replayed
+ */
+WRPARSECXX_API Token &
+TokenRun::lex(
+        Token &token
+)
+{
+        base_t::lex(token);  // initialise token
+
+        if (pos_ >= tokens_.size()) {
+                return token.setKind(TOK_EOF);
+        }
+
+        const Record &record = tokens_[pos_++];
+
+        return token.setKind(record.kind)
+                    .setFlags(record.flags)
+                    .setSpelling(record.spelling)
+                    .setLine(record.line)
+                    .setColumn(record.column)
+                    .adjustOffset(static_cast<ptrdiff_t>(record.offset)
+                                  - static_cast<ptrdiff_t>(token.offset()));
+}
+
+//--------------------------------------
+/**
+ * \brief append a copy of \c token to the run
+ */
+WRPARSECXX_API TokenRun &
+TokenRun::add(
+        const Token &token
+)
+{
+        spellings_.emplace_front(token.spelling().char_data(),
+                                 token.spelling().bytes());
+        tokens_.push_back({ token.kind(), token.flags(),
+                            u8string_view(spellings_.front()),
+                            token.offset(), token.line(), token.column() });
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief source offset of the first token
+ */
+WRPARSECXX_API size_t
+TokenRun::beginOffset() const
+{
+        return tokens_.empty() ? 0 : tokens_.front().offset;
+}
+
+//--------------------------------------
+/**
+ * \brief source offset of the last token
+ */
+WRPARSECXX_API size_t
+TokenRun::endOffset() const
+{
+        return tokens_.empty() ? 0 : tokens_.back().offset;
+}
+
+//--------------------------------------
+/**
+ * \brief source offset just past the end of the last token
+ */
+WRPARSECXX_API size_t
+TokenRun::pastEndOffset() const
+{
+        return tokens_.empty() ? 0 : tokens_.back().offset
+                                     + tokens_.back().spelling.bytes();
+}
+
+//--------------------------------------
+/**
+ * \brief determine if two runs hold the same tokens
+ *
+ * \param [in] other
+ *      run to compare with
+ * \param [in] delta
+ *      amount by which the offset of each token of \c other is expected to
+ *      exceed that of the corresponding token of \c *this
+ */
+WRPARSECXX_API bool
+TokenRun::sameTokens(
+        const this_t &other,
+        ptrdiff_t     delta
+) const
+{
+        if (tokens_.size() != other.tokens_.size()) {
+                return false;
+        }
+
+        for (size_t i = 0; i < tokens_.size(); ++i) {
+                const Record &a = tokens_[i],
+                             &b = other.tokens_[i];
+
+                if ((a.kind != b.kind) || (a.flags != b.flags)
+                                || (static_cast<ptrdiff_t>(a.offset) + delta
+                                    != static_cast<ptrdiff_t>(b.offset))
+                                || (a.spelling != b.spelling)) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+//--------------------------------------
+/**
+ * \brief move every token of the run to the offset, line and column of the
+ *      corresponding token of \c other, as when text has been inserted or
+ *      removed before the run
+ *
+ * \param [in] other
+ *      run holding the same tokens as \c *this (see sameTokens())
+ */
+WRPARSECXX_API TokenRun &
+TokenRun::relocate(
+        const this_t &other
+)
+{
+        for (size_t i = 0; (i < tokens_.size()) && (i < other.size()); ++i) {
+                tokens_[i].offset = other.tokens_[i].offset;
+                tokens_[i].line   = other.tokens_[i].line;
+                tokens_[i].column = other.tokens_[i].column;
+        }
+        return *this;
+}
+
+//--------------------------------------
+/**
+ * \brief move a token replayed from the run to the position of the
+ *      corresponding token of \c other
+ *
+ * Must be called before the run itself is relocated. Tokens a parser
+ * inserted in place of a sequence of the run's tokens take the position of
+ * the first of them; other tokens are left where they are.
+ *
+ * \param [in,out] token
+ *      token at the offset of one of the run's tokens
+ * \param [in] other
+ *      run holding the same tokens as \c *this (see sameTokens())
+ */
+WRPARSECXX_API Token &
+TokenRun::relocate(
+        Token        &token,
+        const this_t &other
+) const
+{
+        auto i = std::lower_bound(tokens_.begin(), tokens_.end(),
+                                  token.offset(),
+                                  [](const Record &record, size_t offset) {
+                                        return record.offset < offset;
+                                  });
+        size_t index = static_cast<size_t>(i - tokens_.begin());
+
+        if ((i == tokens_.end()) || (i->offset != token.offset())
+                                 || (index >= other.size())) {
+                return token;
+        }
+
+        const Record &to = other.tokens_[index];
+
+        return token.setLine(to.line)
+                    .setColumn(to.column)
+                    .adjustOffset(static_cast<ptrdiff_t>(to.offset)
+                                  - static_cast<ptrdiff_t>(token.offset()));
+}
+
+
+} // namespace parse
+} // namespace wr
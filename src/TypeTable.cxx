@@ -0,0 +1,724 @@
+/**
+ * \file TypeTable.cxx
+ *
+ * \brief Interned type representation implementation
+ *
+ * \copyright
+ * \parblock
+ *
+ *   Copyright 2014-2016 James S. Waller
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \endparblock
+ */
+#include <wrutil/CityHash.h>
+#include <wrparse/cxx/CXXTokenKinds.h>
+#include <wrparse/cxx/ExprMatch.h>
+#include <wrparse/cxx/TypeTable.h>
+
+
+namespace wr {
+namespace parse {
+
+
+using namespace cxx;
+
+
+static bool
+isIdentChar(
+        char c
+)
+{
+        return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))
+                || ((c >= '0') && (c <= '9')) || (c == '_')
+                || (static_cast<unsigned char>(c) >= 0x80);
+}
+
+//--------------------------------------
+/*
+ * Canonical spelling of the tokens of a type specifier or expression:
+ * spaced only where needed to keep tokens apart, without class-keys, and
+ * stopping at any class or enumeration body or base clause
+ */
+static std::string
+spell(
+        const SPPFNode &node
+)
+{
+        std::string text;
+
+        for (const Token *t = node.firstToken(); t; t = t->next()) {
+                switch (t->kind()) {
+                case TOK_LBRACE:
+                case TOK_COLON:
+                        return text;
+                case TOK_KW_CLASS:
+                case TOK_KW_STRUCT:
+                case TOK_KW_UNION:
+                case TOK_KW_ENUM:
+                case TOK_KW_TYPENAME:
+                        break;
+                default:
+                        if (!text.empty() && !t->spelling().empty()
+                                        && isIdentChar(text.back())
+                                        && isIdentChar(
+                                                *t->spelling().char_data())) {
+                                text += ' ';
+                        }
+                        text.append(t->spelling().char_data(), t->bytes());
+                        break;
+                }
+
+                if (t == node.lastToken()) {
+                        break;
+                }
+        }
+
+        return text;
+}
+
+//--------------------------------------
+/*
+ * Gather the ptr-operators, nested declarator and suffixes of a declarator
+ * in source order, looking through the nonterminals that merely nest them
+ */
+static void
+declaratorParts(
+        const CXXParser::Grammar      &gram,
+        const SPPFNode                &declarator,
+        std::vector<const SPPFNode *> &parts
+)
+{
+        for (const SPPFNode &part: subProductions(declarator)) {
+                if (part.is(gram.abstract_declarator)
+                                || part.is(gram.ptr_abstract_declarator)
+                                || part.is(gram.noptr_abstract_declarator)
+                                || part.is(gram.abstract_pack_declarator)
+                                || part.is(gram.noptr_abstract_pack_declarator)
+                                || part.is(gram.conversion_declarator)) {
+                        declaratorParts(gram, part, parts);
+                } else {
+                        parts.push_back(&part);
+                }
+        }
+}
+
+//--------------------------------------
+
+WRPARSECXX_API bool
+TypeTable::Type::operator==(
+        const Type &other
+) const
+{
+        return (kind == other.kind) && (qualifiers == other.qualifiers)
+                && (sign == other.sign) && (size == other.size)
+                && (builtin == other.builtin) && (target == other.target)
+                && (name == other.name) && (bound == other.bound)
+                && (parameters == other.parameters)
+                && (variadic == other.variadic);
+}
+
+//--------------------------------------
+
+size_t
+TypeTable::TypeHash::operator()(
+        const Type &type
+) const
+{
+        uint64_t h = type.kind | (uint64_t(type.qualifiers) << 8)
+                                | (uint64_t(type.sign) << 16)
+                                | (uint64_t(type.size) << 24)
+                                | (uint64_t(type.builtin) << 32)
+                                | (uint64_t(type.variadic) << 40);
+
+        auto mix = [&h](uint64_t value) {
+                h = (h ^ value) * UINT64_C(0x100000001b3);
+        };
+
+        mix(reinterpret_cast<uintptr_t>(type.target));
+        mix(type.bound);
+
+        if (!type.name.empty()) {
+                mix(CityHash64(type.name.char_data(), type.name.bytes()));
+        }
+
+        for (const Type *parameter: type.parameters) {
+                mix(reinterpret_cast<uintptr_t>(parameter));
+        }
+
+        return static_cast<size_t>(h ^ (h >> 32));
+}
+
+//--------------------------------------
+/**
+ * \brief type named by a \c decl_specifier_seq, \c type_specifier_seq or
+ *      \c trailing_type_specifier_seq
+ *
+ * \return
+ *      the type, or \c nullptr if the sequence has no type specifier (as
+ *      for a constructor) or has not been annotated by the parser
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::forSpecifiers(
+        CXXParser      &cxx,
+        const SPPFNode &decl_specifier_seq
+)
+{
+        auto  spec = cxx.get<CXXParser::DeclSpecifier>(decl_specifier_seq);
+        auto &gram = cxx.grammar();
+
+        if (!spec) {
+                return nullptr;
+        } else if (((spec->type_spec == Builtin::OTHER)
+                    || (spec->type_spec == Builtin::DECLTYPE))
+                   && spec->type_spec_node) {
+                return named(spell(*spec->type_spec_node), spec->type_qual);
+        } else if (spec->type_spec || spec->sign_spec || spec->size_spec) {
+                return builtin(spec->sign_spec, spec->size_spec,
+                               spec->type_spec, spec->type_qual);
+        }
+
+        for (const SPPFNode &part: subProductions(decl_specifier_seq)) {
+                SPPFNode::ConstPtr name;
+
+                if (part.is(gram.class_specifier)) {
+                        name = part.find(gram.class_head_name, 2);
+                } else if (part.is(gram.enum_specifier)) {
+                        auto head = part.find(gram.enum_head, 1);
+                        name = head ? head->find(gram.identifier, 1)
+                                    : nullptr;
+                } else if (part.is(gram.elaborated_type_specifier)
+                                || part.is(gram.typename_specifier)
+                                || part.is(gram.atomic_type_specifier)) {
+                        name = &part;
+                } else {
+                        continue;
+                }
+
+                if (!name) {  // anonymous, so unique to its definition
+                        return named("<anonymous@"
+                                     + std::to_string(part.firstToken()
+                                                          ->offset())
+                                     + ">", spec->type_qual);
+                }
+
+                return named(spell(*name), spec->type_qual);
+        }
+
+        return nullptr;
+}
+
+//--------------------------------------
+/**
+ * \brief type of the entity a declarator declares
+ *
+ * \param [in] cxx
+ *      parser that produced the nodes
+ * \param [in] decl_specifier_seq
+ *      specifiers of the declaration
+ * \param [in] declarator
+ *      \c declarator, \c abstract_declarator or \c conversion_declarator
+ *      node, or \c nullptr if there is none
+ * \return
+ *      the type, or \c nullptr if it cannot be determined
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::forDeclarator(
+        CXXParser      &cxx,
+        const SPPFNode &decl_specifier_seq,
+        const SPPFNode *declarator
+)
+{
+        const Type *type = forSpecifiers(cxx, decl_specifier_seq);
+
+        if (!type || !declarator) {
+                return type;
+        }
+
+        return applyDeclarator(cxx, type, *declarator);
+}
+
+//--------------------------------------
+/**
+ * \brief type named by a \c type_id node
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::forTypeId(
+        CXXParser      &cxx,
+        const SPPFNode &type_id
+)
+{
+        auto &gram       = cxx.grammar();
+        auto  specifiers = type_id.find(gram.type_specifier_seq, 1);
+        auto  declarator = type_id.find(gram.abstract_declarator, 1);
+
+        return specifiers ? forDeclarator(cxx, *specifiers, declarator.get())
+                          : nullptr;
+}
+
+//--------------------------------------
+
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::builtin(
+        Sign    sign,
+        Size    size,
+        Builtin builtin,
+        uint8_t qualifiers
+)
+{
+        if (!builtin && (sign || size)) {
+                builtin = Builtin::INT;  // "unsigned", "long" etc.
+        }
+
+        if ((sign == Sign::SIGNED) && (builtin == Builtin::INT)) {
+                sign = Sign::NO_SIGN;  // but "signed char" is distinct
+        }
+
+        Type type;
+
+        type.kind       = Type::BUILTIN;
+        type.qualifiers = qualifiers;
+        type.sign       = sign;
+        type.size       = size;
+        type.builtin    = builtin;
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::named(
+        const u8string_view &name,
+        uint8_t              qualifiers
+)
+{
+        Type type;
+
+        type.kind       = Type::NAMED;
+        type.qualifiers = qualifiers;
+        type.name       = internName(name);
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::pointer(
+        const Type *pointee,
+        uint8_t     qualifiers
+)
+{
+        Type type;
+
+        type.kind       = Type::POINTER;
+        type.qualifiers = qualifiers;
+        type.target     = pointee;
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::memberPointer(
+        const u8string_view &class_name,
+        const Type          *pointee,
+        uint8_t              qualifiers
+)
+{
+        Type type;
+
+        type.kind       = Type::MEMBER_POINTER;
+        type.qualifiers = qualifiers;
+        type.target     = pointee;
+        type.name       = internName(class_name);
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+/**
+ * \brief reference to a type, collapsing a reference to a reference as
+ *      the language does
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::reference(
+        const Type *referee,
+        bool        rvalue
+)
+{
+        if (referee->kind == Type::LVALUE_REFERENCE) {
+                return referee;
+        } else if (referee->kind == Type::RVALUE_REFERENCE) {
+                return rvalue ? referee : reference(referee->target, false);
+        }
+
+        Type type;
+
+        type.kind   = rvalue ? Type::RVALUE_REFERENCE
+                             : Type::LVALUE_REFERENCE;
+        type.target = referee;
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+/**
+ * \param [in] element
+ *      element type
+ * \param [in] bound
+ *      number of elements, or \c UNKNOWN_BOUND
+ * \param [in] bound_expr
+ *      spelling of the bound if \c UNKNOWN_BOUND but given by an
+ *      expression; empty if no bound was given
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::array(
+        const Type          *element,
+        uint64_t             bound,
+        const u8string_view &bound_expr
+)
+{
+        Type type;
+
+        type.kind   = Type::ARRAY;
+        type.target = element;
+        type.bound  = bound;
+
+        if (bound == UNKNOWN_BOUND) {
+                type.name = internName(bound_expr);
+        }
+
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+/**
+ * \param [in] result
+ *      return type
+ * \param [in] parameters
+ *      parameter types, already adjusted
+ * \param [in] variadic
+ *      \c true if the parameter list ends with \c ...
+ * \param [in] qualifiers
+ *      cv- and ref-qualifiers of a member function
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::function(
+        const Type                *result,
+        std::vector<const Type *>  parameters,
+        bool                       variadic,
+        uint8_t                    qualifiers
+)
+{
+        Type type;
+
+        type.kind       = Type::FUNCTION;
+        type.qualifiers = qualifiers;
+        type.target     = result;
+        type.parameters = std::move(parameters);
+        type.variadic   = variadic;
+        return intern(std::move(type));
+}
+
+//--------------------------------------
+/**
+ * \brief add qualifiers to a type; those of an array apply to its
+ *      elements, and references cannot be qualified
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::qualified(
+        const Type *type,
+        uint8_t     qualifiers
+)
+{
+        if (!qualifiers || ((type->qualifiers | qualifiers)
+                            == type->qualifiers)) {
+                return type;
+        }
+
+        switch (type->kind) {
+        case Type::ARRAY:
+                return array(qualified(type->target, qualifiers),
+                             type->bound, type->name);
+        case Type::LVALUE_REFERENCE:
+        case Type::RVALUE_REFERENCE:
+                return type;
+        default:
+                break;
+        }
+
+        Type copy = *type;
+
+        copy.qualifiers |= qualifiers;
+        return intern(std::move(copy));
+}
+
+//--------------------------------------
+/**
+ * \brief remove top-level qualifiers from a type other than a function
+ */
+WRPARSECXX_API const TypeTable::Type *
+TypeTable::unqualified(
+        const Type *type
+)
+{
+        if (!type->qualifiers || (type->kind == Type::FUNCTION)) {
+                return type;
+        }
+
+        Type copy = *type;
+
+        copy.qualifiers = 0;
+        return intern(std::move(copy));
+}
+
+//--------------------------------------
+/**
+ * \brief forget all types; pointers to them become invalid
+ */
+WRPARSECXX_API TypeTable &
+TypeTable::clear()
+{
+        types_.clear();
+        names_.clear();
+        return *this;
+}
+
+//--------------------------------------
+
+const TypeTable::Type *
+TypeTable::intern(
+        Type &&type
+)
+{
+        return &*types_.insert(std::move(type)).first;
+}
+
+//--------------------------------------
+
+u8string_view
+TypeTable::internName(
+        const u8string_view &name
+)
+{
+        return u8string_view(*names_.emplace(name.char_data(),
+                                             name.bytes()).first);
+}
+
+//--------------------------------------
+/*
+ * Apply a declarator to the type given by its declaration's specifiers:
+ * ptr-operators in order, then suffixes from the innermost (rightmost)
+ * out, then any nested declarator to the result
+ */
+const TypeTable::Type *
+TypeTable::applyDeclarator(
+        CXXParser      &cxx,
+        const Type     *type,
+        const SPPFNode &declarator
+)
+{
+        auto                          &gram     = cxx.grammar();
+        std::vector<const SPPFNode *>  parts,
+                                       suffixes;
+        const SPPFNode                *nested   = nullptr,
+                                      *trailing = nullptr;
+
+        declaratorParts(gram, declarator, parts);
+
+        for (const SPPFNode *part: parts) {
+                if (part->is(gram.ptr_operator)) {
+                        const Token *op    = part->firstToken();
+                        uint8_t      quals = 0;
+
+                        if (auto dp = cxx.get<CXXParser::DeclaratorPart>(
+                                                                    *part)) {
+                                quals = dp->qualifiers;
+                        }
+
+                        if (op->is(TOK_STAR)) {
+                                type = pointer(type, quals);
+                        } else if (op->is(TOK_AMP)) {
+                                type = reference(type, false);
+                        } else if (op->is(TOK_AMPAMP)) {
+                                type = reference(type, true);
+                        } else {
+                                auto nns = part->find(
+                                        gram.nested_name_specifier, 1);
+                                std::string name = nns ? spell(*nns)
+                                                       : std::string();
+                                if ((name.size() >= 2) && !name.compare(
+                                                name.size() - 2, 2, "::")) {
+                                        name.resize(name.size() - 2);
+                                }
+                                type = memberPointer(name, type, quals);
+                        }
+                } else if (part->is(gram.parameters_and_qualifiers)
+                                || part->is(gram.array_declarator)) {
+                        suffixes.push_back(part);
+                } else if (part->is(gram.nested_declarator)
+                                || part->is(gram.nested_abstract_declarator)) {
+                        nested = part;
+                } else if (part->is(gram.trailing_return_type)) {
+                        trailing = part;
+                }
+        }
+
+        for (auto i = suffixes.rbegin(); type && (i != suffixes.rend()); ++i) {
+                if ((*i)->is(gram.array_declarator)) {
+                        type = arrayOf(cxx, type, **i);
+                        continue;
+                }
+
+                if (trailing) {  // replaces the placeholder return type
+                        auto specifiers = trailing->find(
+                                        gram.trailing_type_specifier_seq, 1);
+                        auto abstract   = trailing->find(
+                                        gram.abstract_declarator, 1);
+
+                        type = specifiers ? forDeclarator(cxx, *specifiers,
+                                                          abstract.get())
+                                          : nullptr;
+                        trailing = nullptr;
+                }
+
+                type = type ? functionOf(cxx, type, **i) : nullptr;
+        }
+
+        if (type && nested) {
+                return applyDeclarator(cxx, type, *nested);
+        }
+
+        return type;
+}
+
+//--------------------------------------
+
+const TypeTable::Type *
+TypeTable::functionOf(
+        CXXParser      &cxx,
+        const Type     *result,
+        const SPPFNode &parameters_and_qualifiers
+)
+{
+        auto                      &gram     = cxx.grammar();
+        auto                       clause   = parameters_and_qualifiers.find(
+                                        gram.parameter_declaration_clause, 1);
+        std::vector<const Type *>  parameters;
+        bool                       variadic = false,
+                                   is_void  = false;
+        uint8_t                    quals    = 0;
+
+        if (auto part = cxx.get<CXXParser::DeclaratorPart>(
+                                                parameters_and_qualifiers)) {
+                variadic = part->variadic;
+                quals = part->qualifiers;
+        }
+
+        if (clause) {
+                for (const SPPFNode &p: subProductions(*clause)) {
+                        if (p.is(TOK_ELLIPSIS)) {
+                                variadic = true;
+                        } else if (p.is(gram.parameter_declaration)) {
+                                auto type = parameterType(cxx, p, is_void);
+                                if (!type) {
+                                        return nullptr;
+                                }
+                                parameters.push_back(type);
+                        }
+                }
+        }
+
+        if (is_void && (parameters.size() == 1) && !variadic) {
+                parameters.clear();  // "(void)"
+        }
+
+        return function(result, std::move(parameters), variadic, quals);
+}
+
+//--------------------------------------
+
+const TypeTable::Type *
+TypeTable::arrayOf(
+        CXXParser      &cxx,
+        const Type     *element,
+        const SPPFNode &array_declarator
+)
+{
+        auto &gram = cxx.grammar();
+        auto  expr = array_declarator.find(gram.constant_expression, 1);
+
+        if (!expr) {
+                expr = array_declarator.find(gram.assignment_expression, 1);
+                if (!expr) {
+                        return array(element, UNKNOWN_BOUND);
+                }
+        }
+
+        ConstExprEvaluator evaluator(cxx);
+        Literal            value;
+
+        if (evaluator.evaluate(*expr, value) && (value.type.intConvRank() > 0)
+                        && !(value.type.isSigned() && (value.i < 0))) {
+                return array(element, value.u);
+        }
+
+        return array(element, UNKNOWN_BOUND, spell(*expr));
+}
+
+//--------------------------------------
+/*
+ * Adjusted type of a function parameter; sets is_void if the parameter
+ * is an unnamed, unqualified void
+ */
+const TypeTable::Type *
+TypeTable::parameterType(
+        CXXParser      &cxx,
+        const SPPFNode &parameter_declaration,
+        bool           &is_void
+)
+{
+        auto &gram       = cxx.grammar();
+        auto  specifiers = parameter_declaration.find(
+                                        gram.decl_specifier_seq, 1);
+        auto  declarator = parameter_declaration.find(gram.declarator, 1);
+
+        if (!specifiers) {
+                return nullptr;
+        } else if (!declarator) {
+                declarator = parameter_declaration.find(
+                                        gram.abstract_declarator, 1);
+        }
+
+        const Type *type = forDeclarator(cxx, *specifiers, declarator.get());
+
+        if (!type) {
+                return nullptr;
+        }
+
+        is_void = !declarator && (type->kind == Type::BUILTIN)
+                              && (type->builtin == Builtin::VOID)
+                              && !type->qualifiers;
+
+        switch (type->kind) {
+        case Type::ARRAY:
+                return pointer(type->target);
+        case Type::FUNCTION:
+                return pointer(type);
+        default:
+                return unqualified(type);
+        }
+}
+
+
+} // namespace parse
+} // namespace wr